@@ -0,0 +1,254 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory_resource>
+#include <random>
+#include <type_traits>
+#include <utility>
+#include "counting_sort.h"
+#include "insertion_sort.h"
+#include "merge_sort.h"
+#include "power_sort.h"
+#include "quick_sort.h"
+#include "radix_sort.h"
+#include "sorting_network.h"
+#include "detail/compare.h"
+#include "detail/iterator.h"
+#include "detail/type_traits.h"
+
+/*
+ * algorithm::sort picks the engine from what is cheap to learn about the input: the element type and comparator,
+ * the size, the iterator category and two presortedness probes. Short ranges go to a sorting network or insertion sort,
+ * ranges made of few runs or with few sampled inversions to the run adaptive power sort, numbers in natural order
+ * to counting or radix sort and everything else to introsort. Lists and other bidirectional ranges are merge sorted.
+ */
+namespace algorithm
+{
+/*
+ * Thresholds of the dispatcher. The defaults are rough crossover points for 32-bit integers on x86-64 rather than
+ * measurements shipped with the library:
+ * - networks are only worth it up to their largest size of 32,
+ * - radix sort pays off once its passes are amortized, and falls behind introsort again when they stream far more memory
+ *   than the cache holds,
+ * - counting sort needs several elements per distinct key to beat radix sort.
+ * Pass a table measured on the target machine to retune them.
+ */
+struct sort_thresholds
+{
+    /* Numbers up to this size are sorted by a sorting network, at most detail::sorting_network_max_size */
+    std::ptrdiff_t network = 32;
+
+    /* Other elements up to this size are sorted by insertion sort */
+    std::ptrdiff_t insertion = 16;
+
+    /* Integers from this size on are counted when their range holds at most one key per counting_density elements */
+    std::ptrdiff_t counting = 1024;
+    std::ptrdiff_t counting_density = 4;
+
+    /* Integers and floats from radix up to radix_max elements are radix sorted */
+    std::ptrdiff_t radix = 256;
+    std::ptrdiff_t radix_max = std::ptrdiff_t{1} << 20;
+
+    /* Ranges whose runs are this long on average are merged by power sort */
+    std::ptrdiff_t run_length = 64;
+
+    /* Pairs of positions compared by the inversion probe */
+    std::ptrdiff_t inversion_samples = 256;
+
+    /* Ranges with at most this share of sampled pairs out of order, or at most this share in order, go to power sort */
+    double inversion_ratio = 0.03;
+};
+
+namespace detail
+{
+enum class sort_engine
+{
+    network,
+    insertion,
+    counting,
+    radix,
+    adaptive_merge,
+    introsort
+};
+
+/* Number of non-descending runs, the counting stops as soon as there are more than limit of them */
+template <typename Iterator, typename Compare>
+std::ptrdiff_t count_runs(Iterator begin, Iterator end, std::ptrdiff_t limit, Compare& comp)
+{
+    std::ptrdiff_t runs = 1;
+    for (auto current = std::next(begin); current != end && runs <= limit; ++current)
+    {
+        runs += comp(*current, *std::prev(current)) ? 1 : 0;
+    }
+    return runs;
+}
+
+/* Share of inverted pairs among random pairs of positions: 0 for a sorted range, 1 for a reverse sorted one, about a half for random data */
+template <typename Iterator, typename Compare>
+double sampled_inversions(Iterator begin, std::ptrdiff_t size, std::ptrdiff_t samples, Compare& comp)
+{
+    /* Seeded by the size, so the same input is always sorted the same way */
+    std::minstd_rand generator{static_cast<std::uint_fast32_t>(size)};
+    std::uniform_int_distribution<std::ptrdiff_t> position{0, size - 1};
+
+    std::ptrdiff_t pairs = 0;
+    std::ptrdiff_t inversions = 0;
+    for (std::ptrdiff_t sample = 0; sample < samples; ++sample)
+    {
+        auto left = position(generator);
+        auto right = position(generator);
+        if (left == right)
+        {
+            continue;
+        }
+        if (right < left)
+        {
+            std::swap(left, right);
+        }
+
+        ++pairs;
+        inversions += comp(begin[right], begin[left]) ? 1 : 0;
+    }
+    return pairs == 0 ? 0.0 : static_cast<double>(inversions) / static_cast<double>(pairs);
+}
+
+/* Routing of a random access range, the probes only run for ranges too long for the small sorts */
+template <typename Iterator, typename Compare>
+sort_engine choose_sort_engine(Iterator begin, Iterator end, const sort_thresholds& thresholds, Compare& comp)
+{
+    using value_type = std::iter_value_t<Iterator>;
+
+    const auto size = end - begin;
+    if constexpr (is_network_sortable_v<Iterator>)
+    {
+        if (size <= std::min(thresholds.network, static_cast<std::ptrdiff_t>(sorting_network_max_size)))
+        {
+            return sort_engine::network;
+        }
+    }
+    if (size <= thresholds.insertion)
+    {
+        return sort_engine::insertion;
+    }
+
+    const auto max_runs = size / std::max(thresholds.run_length, std::ptrdiff_t{1});
+    if (count_runs(begin, end, max_runs, comp) <= max_runs)
+    {
+        return sort_engine::adaptive_merge;
+    }
+    const auto inversions = sampled_inversions(begin, size, thresholds.inversion_samples, comp);
+    if (inversions <= thresholds.inversion_ratio || inversions >= 1.0 - thresholds.inversion_ratio)
+    {
+        return sort_engine::adaptive_merge;
+    }
+
+    /* Digits are read only for the order operator< gives */
+    if constexpr (is_natural_order_v<Compare> && is_radix_key_v<value_type>)
+    {
+        if constexpr (std::is_integral_v<value_type>)
+        {
+            if (size >= thresholds.counting)
+            {
+                const auto [min, max] = std::minmax_element(begin, end);
+                const auto keys = static_cast<std::size_t>(to_radix_key(*max) - to_radix_key(*min));
+                if (keys < static_cast<std::size_t>(size / std::max(thresholds.counting_density, std::ptrdiff_t{1})))
+                {
+                    return sort_engine::counting;
+                }
+            }
+        }
+        /*
+         * Bits order a NaN before or after every number by its sign, while operator< has no place for it at all,
+         * so floats holding one stay with the comparison engines. Radix sort puts -0.0 before 0.0, a valid order
+         * of two equivalent keys for an unstable sort.
+         */
+        if (size >= thresholds.radix && size <= thresholds.radix_max &&
+            (!std::is_floating_point_v<value_type> || std::none_of(begin, end, [](value_type value) { return value != value; })))
+        {
+            return sort_engine::radix;
+        }
+    }
+    return sort_engine::introsort;
+}
+
+template <typename Iterator, typename Compare>
+void adaptive_sort(Iterator begin, Iterator end, const sort_thresholds& thresholds, Compare comp)
+{
+    using value_type = std::iter_value_t<Iterator>;
+
+    const auto size = end - begin;
+    if (size <= 1)
+    {
+        return;
+    }
+
+    switch (choose_sort_engine(begin, end, thresholds, comp))
+    {
+    case sort_engine::network:
+        small_sort(begin, end, size, comp);
+        break;
+    case sort_engine::insertion:
+        insertion_sort(begin, end, comp);
+        break;
+    case sort_engine::counting:
+        if constexpr (std::is_integral_v<value_type> && !std::is_same_v<value_type, bool>)
+        {
+            counting_sort(begin, end, std::pmr::get_default_resource());
+        }
+        break;
+    case sort_engine::radix:
+        if constexpr (is_radix_key_v<value_type>)
+        {
+            radix_sort(begin, end, std::pmr::get_default_resource());
+        }
+        break;
+    case sort_engine::adaptive_merge:
+        power_sort(begin, end, comp);
+        break;
+    case sort_engine::introsort:
+        quick_sort(begin, end, comp);
+        break;
+    }
+}
+}  // namespace detail
+
+/* Routes by the given thresholds instead of the defaults */
+template <typename Range, typename = detail::enable_if_sortable_t<Range>>
+void sort(Range& range, const sort_thresholds& thresholds)
+{
+    if constexpr (std::random_access_iterator<decltype(detail::unwrap(std::begin(range)))>)
+    {
+        detail::adaptive_sort(detail::unwrap(std::begin(range)), detail::unwrap(std::end(range)), thresholds, std::less<>{});
+    }
+    else
+    {
+        merge_sort(range);
+    }
+}
+
+/* Unstable, like std::sort; sorts with the engine that suits the range best */
+template <typename Range, typename = detail::enable_if_sortable_t<Range>>
+void sort(Range& range)
+{
+    algorithm::sort(range, sort_thresholds{});
+}
+
+/* Orders by comp(proj(a), proj(b)), numbers are counted or radix sorted only in the natural order */
+template <typename Range, typename Compare, typename Projection = std::identity,
+          typename = detail::enable_if_sortable_by_t<Range, Compare, Projection>>
+void sort(Range& range, Compare comp, Projection proj = {}, const sort_thresholds& thresholds = {})
+{
+    if constexpr (std::random_access_iterator<decltype(detail::unwrap(std::begin(range)))>)
+    {
+        detail::adaptive_sort(detail::unwrap(std::begin(range)), detail::unwrap(std::end(range)), thresholds, detail::make_compare(comp, proj));
+    }
+    else
+    {
+        merge_sort(range, comp, proj);
+    }
+}
+}  // namespace algorithm
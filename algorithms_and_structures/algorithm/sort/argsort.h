@@ -0,0 +1,165 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <numeric>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <tbb/parallel_sort.h>
+#include "power_sort.h"
+#include "radix_sort.h"
+#include "detail/compare.h"
+#include "detail/iterator.h"
+#include "detail/permutation.h"
+#include "detail/type_traits.h"
+
+/*
+ * Indirect sorting for large records, where moving an element costs far more than comparing it.
+ * argsort sorts an array of indices instead of the elements, and apply_permutation then puts the elements
+ * (and the matching elements of other ranges) into that order in place, moving each of them once.
+ */
+namespace algorithm
+{
+namespace detail
+{
+/* Below this size the threads would spend more time on synchronization than on sorting */
+constexpr std::size_t parallel_argsort_threshold = std::size_t{1} << 14;
+
+template <typename Iterator, typename Compare>
+std::vector<std::size_t> argsort(Iterator begin, Iterator end, Compare comp)
+{
+    const auto size = static_cast<std::size_t>(std::distance(begin, end));
+    std::vector<std::size_t> order(size);
+    std::iota(order.begin(), order.end(), std::size_t{0});
+
+    /* Indices start in order and power sort is stable, so equal elements keep their order */
+    const auto position = index_positions(begin, size);
+    power_sort(order.data(), order.data() + size,
+               [&position, &comp](std::size_t lhs, std::size_t rhs) { return comp(*position(lhs), *position(rhs)); });
+    return order;
+}
+
+template <typename Iterator, typename Compare>
+std::vector<std::size_t> parallel_argsort(Iterator begin, Iterator end, Compare comp)
+{
+    const auto size = static_cast<std::size_t>(std::distance(begin, end));
+    if (size < parallel_argsort_threshold)
+    {
+        return argsort(begin, end, comp);
+    }
+
+    std::vector<std::size_t> order(size);
+    std::iota(order.begin(), order.end(), std::size_t{0});
+
+    /* The parallel sort is not stable, equal elements are ordered by their index to give the same result as argsort */
+    const auto position = index_positions(begin, size);
+    tbb::parallel_sort(order.begin(), order.end(),
+                       [&position, &comp](std::size_t lhs, std::size_t rhs)
+                       {
+                           if (comp(*position(lhs), *position(rhs)))
+                           {
+                               return true;
+                           }
+                           return !comp(*position(rhs), *position(lhs)) && lhs < rhs;
+                       });
+    return order;
+}
+
+/* LSD radix sort of the keys which carries the indices along, every pass is stable so equal keys keep their order */
+template <std::size_t DigitBits, typename Iterator, typename Projection>
+std::vector<std::size_t> radix_argsort(Iterator begin, Iterator end, Projection& proj)
+{
+    using projected_type = std::remove_cvref_t<std::invoke_result_t<Projection&, std::iter_reference_t<Iterator>>>;
+    using key_type = radix_key_t<projected_type>;
+    using digits = radix_digits<key_type, DigitBits>;
+
+    const auto size = static_cast<std::size_t>(std::distance(begin, end));
+    std::vector<key_type> keys;
+    std::vector<std::size_t> order(size);
+    std::vector<key_type> key_buffer(size);
+    std::vector<std::size_t> order_buffer(size);
+    std::vector<std::size_t> histograms(digits::passes * digits::buckets);
+    keys.reserve(size);
+    std::iota(order.begin(), order.end(), std::size_t{0});
+
+    /* Histograms of all the digits are gathered in one read of the range */
+    for (auto it = begin; it != end; ++it)
+    {
+        const auto key = to_radix_key(std::invoke(proj, *it));
+        keys.push_back(key);
+        for (std::size_t pass = 0; pass < digits::passes; ++pass)
+        {
+            ++histograms[pass * digits::buckets + digits::digit(key, pass)];
+        }
+    }
+
+    for (std::size_t pass = 0; pass < digits::passes && size > 0; ++pass)
+    {
+        auto count = std::next(histograms.begin(), static_cast<std::ptrdiff_t>(pass * digits::buckets));
+
+        /* All keys fall into one bucket, the pass would only copy them */
+        if (count[digits::digit(keys.front(), pass)] == size)
+        {
+            continue;
+        }
+
+        std::size_t offset = 0;
+        for (std::size_t bucket = 0; bucket < digits::buckets; ++bucket)
+        {
+            offset += std::exchange(count[bucket], offset);
+        }
+
+        for (std::size_t index = 0; index < size; ++index)
+        {
+            const auto target = count[digits::digit(keys[index], pass)]++;
+            key_buffer[target] = keys[index];
+            order_buffer[target] = order[index];
+        }
+        keys.swap(key_buffer);
+        order.swap(order_buffer);
+    }
+    return order;
+}
+}  // namespace detail
+
+/* Indices of the elements in sorted order, range[order[0]] is the smallest one; stable, the range itself is not modified */
+template <typename Range, typename Compare = std::less<>, typename Projection = std::identity,
+          typename = detail::enable_if_sortable_by_t<const Range, Compare, Projection>>
+std::vector<std::size_t> argsort(const Range& range, Compare comp = {}, Projection proj = {})
+{
+    return detail::argsort(detail::unwrap(std::begin(range)), detail::unwrap(std::end(range)), detail::make_compare(comp, proj));
+}
+
+/* Multithreaded argsort for large ranges, the comparator and the projection are called from several threads at once */
+template <typename Range, typename Compare = std::less<>, typename Projection = std::identity,
+          typename = detail::enable_if_sortable_by_t<const Range, Compare, Projection>>
+std::vector<std::size_t> parallel_argsort(const Range& range, Compare comp = {}, Projection proj = {})
+{
+    return detail::parallel_argsort(detail::unwrap(std::begin(range)), detail::unwrap(std::end(range)), detail::make_compare(comp, proj));
+}
+
+/* Argsort by a numeric key, e.g. a member pointer to a score, without comparisons */
+template <std::size_t DigitBits = 8, typename Range, typename Projection = std::identity,
+          typename = detail::enable_if_radix_sortable_by_t<const Range, Projection>>
+std::vector<std::size_t> radix_argsort(const Range& range, Projection proj = {})
+{
+    return detail::radix_argsort<DigitBits>(detail::unwrap(std::begin(range)), detail::unwrap(std::end(range)), proj);
+}
+
+/*
+ * Reorders every given range so that its element i becomes its former element order[i], in place.
+ * The order has to be a permutation of 0 ... n - 1 and every range has to hold n elements.
+ */
+template <typename... Ranges, typename = std::enable_if_t<(detail::is_sortable_v<Ranges> && ...)>>
+void apply_permutation(std::span<const std::size_t> order, Ranges&... ranges)
+{
+    /* The walk marks visited positions in the order, so it works on a copy */
+    std::vector<std::size_t> remaining(order.begin(), order.end());
+    std::tuple positions{detail::index_positions(detail::unwrap(std::begin(ranges)), order.size())...};
+    std::apply([&remaining](auto&... position) { detail::apply_permutation(remaining, position...); }, positions);
+}
+}  // namespace algorithm
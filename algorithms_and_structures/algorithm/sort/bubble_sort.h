@@ -1,6 +1,15 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include "detail/compare.h"
+#include "detail/execution.h"
+#include "detail/iterator.h"
 #include "detail/type_traits.h"
 
 /* Operation iterator +/- n requires random access iterator, we have bidirectorial one so we use std::next, std::prev */
@@ -8,8 +17,8 @@ namespace algorithm
 {
 namespace detail
 {
-template <typename Iterator>
-void bubble_sort(Iterator begin, Iterator end)
+template <typename Iterator, typename Compare = std::less<>>
+void bubble_sort(Iterator begin, Iterator end, Compare comp = {})
 {
     /* Start iteration from the right */
     for (auto right = std::prev(end); right != begin; --right)
@@ -17,20 +26,110 @@ void bubble_sort(Iterator begin, Iterator end)
         /* Use second iterator for comparing values from the left */
         for (auto left = begin; left != right; ++left)
         {
-            if (*left > *right)
+            if (comp(*right, *left))
             {
-                std::swap(*left, *right);
+                std::iter_swap(left, right);
             }
         }
     }
 }
+
+/* Phases with fewer pairs than this are not split between threads */
+constexpr std::ptrdiff_t parallel_bubble_sort_threshold = std::ptrdiff_t{1} << 12;
+
+/* Orders a pair and tells whether it was swapped, numbers are exchanged through min and max so the loop has no branches */
+template <typename Iterator, typename Compare>
+bool transpose_pair(Iterator left, Iterator right, Compare& comp)
+{
+    using value_type = std::iter_value_t<Iterator>;
+
+    if constexpr (std::is_arithmetic_v<value_type> && is_natural_order_v<Compare>)
+    {
+        const value_type first = *left;
+        const value_type second = *right;
+        const bool swap = second < first;
+        *left = swap ? second : first;
+        *right = swap ? first : second;
+        return swap;
+    }
+    else
+    {
+        if (comp(*right, *left))
+        {
+            std::iter_swap(left, right);
+            return true;
+        }
+        return false;
+    }
+}
+
+/* One phase of the odd-even transposition sort: the disjoint pairs (parity + 2 * pair, parity + 2 * pair + 1) from first to last */
+template <typename Iterator, typename Compare>
+bool odd_even_phase(Iterator begin, std::ptrdiff_t parity, std::ptrdiff_t first, std::ptrdiff_t last, Compare& comp)
+{
+    /* Swaps are counted rather than or-ed into a flag, the compiler vectorizes a sum but not the flag */
+    std::ptrdiff_t swaps = 0;
+    for (auto pair = first; pair < last; ++pair)
+    {
+        const auto left = begin + (parity + 2 * pair);
+        swaps += transpose_pair(left, left + 1, comp);
+    }
+    return swaps != 0;
+}
+
+/*
+ * Odd-even transposition sort, the bubble sort whose swaps within one pass are independent of each other.
+ * Under the unsequenced policies the pairs of a phase are exchanged without branches, under the parallel ones
+ * the pairs are split between threads. Two phases in a row without a swap mean the range is sorted.
+ */
+template <typename ExecutionPolicy, typename Iterator, typename Compare>
+void bubble_sort(const ExecutionPolicy&, Iterator begin, Iterator end, Compare comp)
+{
+    if constexpr (!std::random_access_iterator<Iterator> || !(is_parallel_policy_v<ExecutionPolicy> || is_unsequenced_policy_v<ExecutionPolicy>))
+    {
+        bubble_sort(begin, end, comp);
+    }
+    else
+    {
+        const auto size = end - begin;
+
+        /* The first phase alone proves nothing, the pairs of the other parity have not been compared yet */
+        bool swapped_before = true;
+        bool sorted = false;
+        for (std::ptrdiff_t phase = 0; !sorted; ++phase)
+        {
+            const auto pairs = (size - phase % 2) / 2;
+            bool swapped = false;
+            if (is_parallel_policy_v<ExecutionPolicy> && pairs >= parallel_bubble_sort_threshold)
+            {
+                std::atomic<bool> any_swapped{false};
+                tbb::parallel_for(tbb::blocked_range<std::ptrdiff_t>{0, pairs, parallel_bubble_sort_threshold / 4},
+                                  [&](const auto& range)
+                                  {
+                                      if (odd_even_phase(begin, phase % 2, range.begin(), range.end(), comp))
+                                      {
+                                          any_swapped.store(true, std::memory_order_relaxed);
+                                      }
+                                  });
+                swapped = any_swapped.load(std::memory_order_relaxed);
+            }
+            else
+            {
+                swapped = odd_even_phase(begin, phase % 2, 0, pairs, comp);
+            }
+
+            sorted = !swapped && !swapped_before;
+            swapped_before = swapped;
+        }
+    }
+}
 }  // namespace detail
 
 template <typename Range, typename = detail::enable_if_sortable_t<Range>>
 void bubble_sort(Range& range)
 {
-    auto begin = std::begin(range);
-    auto end = std::end(range);
+    auto begin = detail::unwrap(std::begin(range));
+    auto end = detail::unwrap(std::end(range));
 
     if (begin == end)
     {
@@ -39,4 +138,49 @@ void bubble_sort(Range& range)
 
     detail::bubble_sort(begin, end);
 }
+
+template <typename Range, typename Compare, typename Projection = std::identity,
+          typename = detail::enable_if_sortable_by_t<Range, Compare, Projection>>
+void bubble_sort(Range& range, Compare comp, Projection proj = {})
+{
+    auto begin = detail::unwrap(std::begin(range));
+    auto end = detail::unwrap(std::end(range));
+
+    if (begin == end)
+    {
+        return;
+    }
+
+    detail::bubble_sort(begin, end, detail::make_compare(comp, proj));
+}
+
+/* Odd-even transposition sort under the unseq and parallel policies, the policies are described in detail/execution.h */
+template <typename ExecutionPolicy, typename Range, typename = detail::enable_if_execution_policy_t<ExecutionPolicy, Range>>
+void bubble_sort(ExecutionPolicy&& policy, Range& range)
+{
+    auto begin = detail::unwrap(std::begin(range));
+    auto end = detail::unwrap(std::end(range));
+
+    if (begin == end)
+    {
+        return;
+    }
+
+    detail::bubble_sort(policy, begin, end, std::less<>{});
+}
+
+template <typename ExecutionPolicy, typename Range, typename Compare, typename Projection = std::identity,
+          typename = detail::enable_if_execution_policy_by_t<ExecutionPolicy, Range, Compare, Projection>>
+void bubble_sort(ExecutionPolicy&& policy, Range& range, Compare comp, Projection proj = {})
+{
+    auto begin = detail::unwrap(std::begin(range));
+    auto end = detail::unwrap(std::end(range));
+
+    if (begin == end)
+    {
+        return;
+    }
+
+    detail::bubble_sort(policy, begin, end, detail::make_compare(comp, proj));
+}
 }  // namespace algorithm
@@ -1,11 +1,325 @@
 #pragma once
 
-#include "include/type_traits.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <execution>
+#include <iterator>
+#include <memory_resource>
+#include <new>
+#include <numeric>
+#include <span>
+#include <utility>
+#include <vector>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_reduce.h>
+#include "quick_sort.h"
+#include "radix_sort.h"
+#include "sorting_network.h"
+#include "detail/buffer.h"
+#include "detail/execution.h"
+#include "detail/iterator.h"
+#include "detail/type_traits.h"
 
 namespace algorithm
 {
 namespace detail
 {
+/* Uniform keys fill every bucket with this many elements on average */
+constexpr std::size_t bucket_sort_elements_per_bucket = 4;
 
+/* Buckets up to this size are finished with a sorting network, larger ones mean the keys are not uniform and go to quick sort */
+constexpr std::size_t bucket_sort_small_threshold = 32;
+
+template <typename T>
+using bucket_real_t = std::conditional_t<std::is_same_v<T, long double>, long double, double>;
+
+/* Maps values to buckets linearly over the observed range; the mapping never decreases, so buckets come out ordered */
+template <typename T>
+struct bucket_mapping
+{
+    std::size_t bucket(T value) const
+    {
+        const auto position = (static_cast<bucket_real_t<T>>(value) - min) * scale;
+        return std::min(static_cast<std::size_t>(position), last);
+    }
+
+    bucket_real_t<T> min;
+    bucket_real_t<T> scale;
+    std::size_t last;
+};
+
+/* Enough buckets for a few elements each, but no more than there are distinct integers in the range of min < max */
+template <typename T>
+bucket_mapping<T> make_bucket_mapping(std::size_t size, T min, T max)
+{
+    using real_type = bucket_real_t<T>;
+
+    auto buckets = std::max(size / bucket_sort_elements_per_bucket, std::size_t{1});
+    if constexpr (std::is_integral_v<T>)
+    {
+        const auto distinct = to_radix_key(max) - to_radix_key(min);
+        if (distinct < buckets)
+        {
+            buckets = static_cast<std::size_t>(distinct) + 1;
+        }
+    }
+    const auto width = static_cast<real_type>(max) - static_cast<real_type>(min);
+    return {static_cast<real_type>(min), static_cast<real_type>(buckets) / width, buckets - 1};
+}
+
+/* Buckets are ordered among themselves, so sorting each of them sorts the whole buffer */
+template <typename Iterator>
+void sort_bucket(Iterator first, Iterator last)
+{
+    const auto bucket_size = std::distance(first, last);
+    if (bucket_size <= 1)
+    {
+        return;
+    }
+
+    if (bucket_size <= static_cast<std::ptrdiff_t>(bucket_sort_small_threshold))
+    {
+        small_sort(first, last, bucket_size);
+    }
+    else
+    {
+        quick_sort(first, last);
+    }
+}
+
+template <typename Iterator>
+void bucket_sort(Iterator begin, Iterator end, std::pmr::memory_resource* resource)
+{
+    using value_type = std::iter_value_t<Iterator>;
+    using real_type = bucket_real_t<value_type>;
+
+    const auto size = static_cast<std::size_t>(std::distance(begin, end));
+    const auto [min_it, max_it] = std::minmax_element(begin, end);
+    const auto min = *min_it;
+    const auto max = *max_it;
+    if (!(min < max))
+    {
+        return;
+    }
+
+    const auto width = static_cast<real_type>(max) - static_cast<real_type>(min);
+    if (!std::isfinite(width))
+    {
+        /* Infinite range would put every finite value in one bucket */
+        quick_sort(begin, end);
+        return;
+    }
+
+    const auto mapping = make_bucket_mapping(size, min, max);
+    if (!std::isfinite(mapping.scale))
+    {
+        /* A range narrower than the buckets can be told apart, e.g. of denormals, would overflow the scale */
+        quick_sort(begin, end);
+        return;
+    }
+    const auto buckets = mapping.last + 1;
+
+    std::pmr::vector<std::size_t> offsets{resource};
+    std::pmr::vector<std::size_t> next{resource};
+    std::pmr::vector<value_type> buffer{resource};
+    try
+    {
+        offsets.resize(buckets + 1);
+        next.resize(buckets + 1);
+        buffer.resize(size);
+    }
+    catch (const std::bad_alloc&)
+    {
+        /* No room for the buckets, sort in place instead */
+        quick_sort(begin, end);
+        return;
+    }
+
+    /* Count bucket sizes and turn them into bucket boundaries in one contiguous buffer */
+    for (auto it = begin; it != end; ++it)
+    {
+        ++offsets[mapping.bucket(*it) + 1];
+    }
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+    std::copy(offsets.begin(), offsets.end(), next.begin());
+    for (auto it = begin; it != end; ++it)
+    {
+        buffer[next[mapping.bucket(*it)]++] = *it;
+    }
+
+    for (std::size_t bucket = 0; bucket < buckets; ++bucket)
+    {
+        sort_bucket(buffer.data() + offsets[bucket], buffer.data() + offsets[bucket + 1]);
+    }
+
+    std::copy(buffer.begin(), buffer.end(), begin);
+}
+
+/*
+ * The bounds are found, the buckets counted and filled and then sorted and copied back on several threads. Elements are
+ * counted and placed through atomic increments of the bucket offsets; with a few elements per bucket they rarely collide.
+ */
+template <typename Iterator>
+void parallel_bucket_sort(Iterator begin, Iterator end)
+{
+    using value_type = std::iter_value_t<Iterator>;
+    using real_type = bucket_real_t<value_type>;
+
+    const auto size = static_cast<std::size_t>(std::distance(begin, end));
+    if constexpr (!std::random_access_iterator<Iterator>)
+    {
+        bucket_sort(begin, end, std::pmr::get_default_resource());
+    }
+    else if (size < parallel_distribution_sort_threshold)
+    {
+        bucket_sort(begin, end, std::pmr::get_default_resource());
+    }
+    else
+    {
+        using bounds = std::pair<value_type, value_type>;
+        const auto element = [begin](std::size_t index) -> value_type { return begin[static_cast<std::ptrdiff_t>(index)]; };
+        const auto [min, max] = tbb::parallel_reduce(
+            tbb::blocked_range<std::size_t>{0, size}, bounds{*begin, *begin},
+            [&](const auto& range, bounds found)
+            {
+                for (auto index = range.begin(); index != range.end(); ++index)
+                {
+                    const auto value = element(index);
+                    found = {std::min(found.first, value), std::max(found.second, value)};
+                }
+                return found;
+            },
+            [](const bounds& lhs, const bounds& rhs) { return bounds{std::min(lhs.first, rhs.first), std::max(lhs.second, rhs.second)}; });
+        if (!(min < max))
+        {
+            return;
+        }
+
+        if (!std::isfinite(static_cast<real_type>(max) - static_cast<real_type>(min)))
+        {
+            quick_sort(std::execution::par, begin, end, std::less<>{});
+            return;
+        }
+
+        const auto mapping = make_bucket_mapping(size, min, max);
+        if (!std::isfinite(mapping.scale))
+        {
+            quick_sort(std::execution::par, begin, end, std::less<>{});
+            return;
+        }
+        const auto buckets = mapping.last + 1;
+        const auto elements = tbb::blocked_range<std::size_t>{0, size};
+
+        std::vector<std::size_t> offsets(buckets + 1);
+        tbb::parallel_for(elements,
+                          [&](const auto& range)
+                          {
+                              for (auto index = range.begin(); index != range.end(); ++index)
+                              {
+                                  std::atomic_ref{offsets[mapping.bucket(element(index)) + 1]}.fetch_add(1, std::memory_order_relaxed);
+                              }
+                          });
+        std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+        /* Order inside a bucket does not matter, it gets sorted anyway */
+        std::vector<value_type> buffer(size);
+        std::vector<std::size_t> next(offsets);
+        tbb::parallel_for(elements,
+                          [&](const auto& range)
+                          {
+                              for (auto index = range.begin(); index != range.end(); ++index)
+                              {
+                                  const auto value = element(index);
+                                  buffer[std::atomic_ref{next[mapping.bucket(value)]}.fetch_add(1, std::memory_order_relaxed)] = value;
+                              }
+                          });
+
+        tbb::parallel_for(tbb::blocked_range<std::size_t>{0, buckets},
+                          [&](const auto& range)
+                          {
+                              for (auto bucket = range.begin(); bucket != range.end(); ++bucket)
+                              {
+                                  sort_bucket(buffer.data() + offsets[bucket], buffer.data() + offsets[bucket + 1]);
+                              }
+                          });
+
+        tbb::parallel_for(elements,
+                          [&](const auto& range)
+                          {
+                              std::copy(buffer.data() + range.begin(), buffer.data() + range.end(),
+                                        begin + static_cast<std::ptrdiff_t>(range.begin()));
+                          });
+    }
+}
+
+/* The parallel policies fill and sort the buckets on several threads, the others run the sequential bucket sort */
+template <typename ExecutionPolicy, typename Iterator>
+void bucket_sort(const ExecutionPolicy&, Iterator begin, Iterator end)
+{
+    if constexpr (is_parallel_policy_v<ExecutionPolicy>)
+    {
+        parallel_bucket_sort(begin, end);
+    }
+    else
+    {
+        bucket_sort(begin, end, std::pmr::get_default_resource());
+    }
+}
 }  // namespace detail
+
+template <typename Range, typename = detail::enable_if_bucket_sortable_t<Range>>
+void bucket_sort(Range& range)
+{
+    auto begin = detail::unwrap(std::begin(range));
+    auto end = detail::unwrap(std::end(range));
+
+    if (begin == end)
+    {
+        return;
+    }
+
+    detail::bucket_sort(begin, end, std::pmr::get_default_resource());
+}
+
+/* Takes the buckets from the given resource, without enough memory the range is sorted in place by quick_sort */
+template <typename Range, typename = detail::enable_if_bucket_sortable_t<Range>>
+void bucket_sort(Range& range, std::pmr::memory_resource* resource)
+{
+    auto begin = detail::unwrap(std::begin(range));
+    auto end = detail::unwrap(std::end(range));
+
+    if (begin == end)
+    {
+        return;
+    }
+
+    detail::bucket_sort(begin, end, resource);
+}
+
+/* Never allocates, the buckets are taken from the given memory */
+template <typename Range, typename = detail::enable_if_bucket_sortable_t<Range>>
+void bucket_sort(Range& range, std::span<std::byte> scratch)
+{
+    detail::scratch_resource resource{scratch};
+    bucket_sort(range, &resource);
+}
+
+/* The policies are described in detail/execution.h */
+template <typename ExecutionPolicy, typename Range, typename = detail::enable_if_execution_policy_t<ExecutionPolicy, Range>,
+          typename = detail::enable_if_bucket_sortable_t<Range>>
+void bucket_sort(ExecutionPolicy&& policy, Range& range)
+{
+    auto begin = detail::unwrap(std::begin(range));
+    auto end = detail::unwrap(std::end(range));
+
+    if (begin == end)
+    {
+        return;
+    }
+
+    detail::bucket_sort(policy, begin, end);
+}
 }  // namespace algorithm
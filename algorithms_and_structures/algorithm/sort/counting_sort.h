@@ -1,6 +1,24 @@
 #pragma once
 
 #include <algorithm>
+#include <climits>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <memory_resource>
+#include <new>
+#include <numeric>
+#include <span>
+#include <utility>
+#include <vector>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_reduce.h>
+#include <tbb/task_arena.h>
+#include "radix_sort.h"
+#include "detail/buffer.h"
+#include "detail/execution.h"
+#include "detail/iterator.h"
 #include "detail/type_traits.h"
 
 /* Operation iterator +/- n requires random access iterator, we have bidirectorial one so we use std::next, std::prev */
@@ -8,6 +26,379 @@ namespace algorithm
 {
 namespace detail
 {
+/* Histograms with fewer buckets than this are always fine, even for very short ranges */
+constexpr std::size_t counting_sort_minimal_histogram = 256;
 
+/* Consecutive elements are counted in different copies of the histogram, so increments of equal keys do not wait for each other */
+constexpr std::size_t counting_sort_sub_histograms = 4;
+
+/* Keys are counted through their order preserving unsigned representation, enums through their underlying type */
+template <typename Key>
+constexpr auto to_counting_key(Key key)
+{
+    if constexpr (std::is_enum_v<Key>)
+    {
+        return to_radix_key(static_cast<std::underlying_type_t<Key>>(key));
+    }
+    else
+    {
+        return to_radix_key(key);
+    }
+}
+
+template <typename Key>
+using counting_key_t = decltype(to_counting_key(std::declval<Key>()));
+
+template <typename Iterator, typename KeyExtractor>
+using counting_sort_key_t = std::remove_cvref_t<std::invoke_result_t<KeyExtractor&, std::iter_reference_t<Iterator>>>;
+
+template <typename Iterator, typename KeyExtractor, typename Key>
+std::pmr::vector<std::size_t> count_keys(Iterator begin, Iterator end, KeyExtractor& key_of, Key min, std::size_t buckets,
+                                         std::pmr::memory_resource* resource)
+{
+    std::pmr::vector<std::size_t> histograms{resource};
+    try
+    {
+        histograms.resize(counting_sort_sub_histograms * buckets);
+    }
+    catch (const std::bad_alloc&)
+    {
+        return histograms;
+    }
+
+    std::size_t lane = 0;
+    for (auto it = begin; it != end; ++it)
+    {
+        const auto key = to_counting_key(std::invoke(key_of, *it));
+        ++histograms[lane * buckets + static_cast<std::size_t>(key - min)];
+        lane = (lane + 1) % counting_sort_sub_histograms;
+    }
+
+    /* Fold the copies into the first one */
+    for (lane = 1; lane < counting_sort_sub_histograms; ++lane)
+    {
+        for (std::size_t bucket = 0; bucket < buckets; ++bucket)
+        {
+            histograms[bucket] += histograms[lane * buckets + bucket];
+        }
+    }
+    histograms.resize(buckets);
+    return histograms;
+}
+
+/*
+ * Returns the histogram of the keys together with the smallest key,
+ * or an empty histogram if the keys are too sparse or there is no memory for counting them.
+ * Keys of at most 16 bits are counted over their whole domain when the range is long enough, which saves the min/max pass.
+ */
+template <typename Iterator, typename KeyExtractor>
+auto counting_histogram(Iterator begin, Iterator end, std::size_t size, KeyExtractor& key_of, std::pmr::memory_resource* resource)
+{
+    using key_type = counting_key_t<counting_sort_key_t<Iterator, KeyExtractor>>;
+    using result_type = std::pair<std::pmr::vector<std::size_t>, key_type>;
+
+    constexpr auto key_bits = sizeof(key_type) * CHAR_BIT;
+    if constexpr (key_bits <= 16)
+    {
+        constexpr auto domain = std::size_t{1} << key_bits;
+        if (size >= domain)
+        {
+            return result_type{count_keys(begin, end, key_of, key_type{0}, domain, resource), key_type{0}};
+        }
+    }
+
+    auto min = to_counting_key(std::invoke(key_of, *begin));
+    auto max = min;
+    for (auto it = std::next(begin); it != end; ++it)
+    {
+        const auto key = to_counting_key(std::invoke(key_of, *it));
+        min = std::min(min, key);
+        max = std::max(max, key);
+    }
+
+    /* Dense histogram only pays off when it is not much longer than the range itself */
+    if (static_cast<std::size_t>(max - min) >= std::max(size, counting_sort_minimal_histogram))
+    {
+        return result_type{{}, min};
+    }
+    return result_type{count_keys(begin, end, key_of, min, static_cast<std::size_t>(max - min) + 1, resource), min};
+}
+
+template <typename Iterator>
+void counting_sort(Iterator begin, Iterator end, std::pmr::memory_resource* resource)
+{
+    using value_type = std::iter_value_t<Iterator>;
+
+    const auto size = static_cast<std::size_t>(std::distance(begin, end));
+    std::identity key_of;
+    const auto [counts, min] = counting_histogram(begin, end, size, key_of, resource);
+    if (counts.empty())
+    {
+        radix_sort(begin, end, resource);
+        return;
+    }
+
+    /* The values are fully described by the histogram, so they are just written back in order */
+    for (std::size_t bucket = 0; bucket < counts.size(); ++bucket)
+    {
+        const auto value = from_radix_key<value_type>(static_cast<radix_key_t<value_type>>(min + bucket));
+        begin = std::fill_n(begin, counts[bucket], value);
+    }
+}
+
+/*
+ * Every chunk of the range is counted by one task into its own histogram, the histograms are summed bucket by bucket
+ * and the values are written back by tasks owning equal parts of the output. Keys too sparse to count go to parallel_radix_sort.
+ */
+template <typename Iterator>
+void parallel_counting_sort(Iterator begin, Iterator end)
+{
+    using value_type = std::iter_value_t<Iterator>;
+    using key_type = counting_key_t<value_type>;
+
+    const auto size = static_cast<std::size_t>(std::distance(begin, end));
+    if constexpr (!std::random_access_iterator<Iterator>)
+    {
+        counting_sort(begin, end, std::pmr::get_default_resource());
+    }
+    else if (size < parallel_distribution_sort_threshold)
+    {
+        counting_sort(begin, end, std::pmr::get_default_resource());
+    }
+    else
+    {
+        const auto key_at = [begin](std::size_t index) { return to_counting_key(begin[static_cast<std::ptrdiff_t>(index)]); };
+        using bounds = std::pair<key_type, key_type>;
+        const auto [min, max] = tbb::parallel_reduce(
+            tbb::blocked_range<std::size_t>{0, size}, bounds{std::numeric_limits<key_type>::max(), key_type{0}},
+            [&](const auto& range, bounds found)
+            {
+                for (auto index = range.begin(); index != range.end(); ++index)
+                {
+                    const auto key = key_at(index);
+                    found = {std::min(found.first, key), std::max(found.second, key)};
+                }
+                return found;
+            },
+            [](const bounds& lhs, const bounds& rhs) { return bounds{std::min(lhs.first, rhs.first), std::max(lhs.second, rhs.second)}; });
+
+        if (static_cast<std::size_t>(max - min) >= std::max(size, counting_sort_minimal_histogram))
+        {
+            parallel_radix_sort(begin, end);
+            return;
+        }
+
+        /* A single thread counts with the sequential sort, which has its own fallbacks */
+        const auto threads = static_cast<std::size_t>(tbb::this_task_arena::max_concurrency());
+        if (threads < 2)
+        {
+            counting_sort(begin, end, std::pmr::get_default_resource());
+            return;
+        }
+
+        /*
+         * All the histograms together hold at most one counter per element, like the sequential histogram, so the memory
+         * does not grow with the number of threads. Keys too wide for two histograms go to the radix sort.
+         */
+        const auto buckets = static_cast<std::size_t>(max - min) + 1;
+        const auto chunks = std::min(threads, size / buckets);
+        if (chunks < 2)
+        {
+            parallel_radix_sort(begin, end);
+            return;
+        }
+
+        /* Histogram of the chunk c is stored on positions c * buckets ... (c + 1) * buckets - 1 */
+        const auto chunk_size = (size + chunks - 1) / chunks;
+        std::vector<std::size_t> histograms;
+        std::vector<std::size_t> offsets;
+        try
+        {
+            histograms.resize(chunks * buckets);
+            offsets.resize(buckets + 1);
+        }
+        catch (const std::bad_alloc&)
+        {
+            parallel_radix_sort(begin, end);
+            return;
+        }
+        tbb::parallel_for(
+            tbb::blocked_range<std::size_t>{0, chunks, 1},
+            [&](const auto& range)
+            {
+                for (auto chunk = range.begin(); chunk != range.end(); ++chunk)
+                {
+                    auto histogram = histograms.data() + chunk * buckets;
+                    const auto last = std::min((chunk + 1) * chunk_size, size);
+                    for (auto index = std::min(chunk * chunk_size, size); index < last; ++index)
+                    {
+                        ++histogram[static_cast<std::size_t>(key_at(index) - min)];
+                    }
+                }
+            },
+            tbb::static_partitioner{});
+
+        /* Bucket b starts at offsets[b] and ends at offsets[b + 1] */
+        tbb::parallel_for(tbb::blocked_range<std::size_t>{0, buckets},
+                          [&](const auto& range)
+                          {
+                              for (auto bucket = range.begin(); bucket != range.end(); ++bucket)
+                              {
+                                  for (std::size_t chunk = 0; chunk < chunks; ++chunk)
+                                  {
+                                      offsets[bucket + 1] += histograms[chunk * buckets + bucket];
+                                  }
+                              }
+                          });
+        std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+        /* Every task fills its part of the output starting from the bucket its first position falls into */
+        tbb::parallel_for(tbb::blocked_range<std::size_t>{0, size},
+                          [&](const auto& range)
+                          {
+                              const auto first = std::upper_bound(offsets.begin(), offsets.end(), range.begin());
+                              auto bucket = static_cast<std::size_t>(first - offsets.begin()) - 1;
+                              for (auto index = range.begin(); index != range.end(); ++bucket)
+                              {
+                                  const auto last = std::min(offsets[bucket + 1], range.end());
+                                  const auto value = from_radix_key<value_type>(static_cast<radix_key_t<value_type>>(min + bucket));
+                                  std::fill(begin + static_cast<std::ptrdiff_t>(index), begin + static_cast<std::ptrdiff_t>(last), value);
+                                  index = last;
+                              }
+                          });
+    }
+}
+
+/* The parallel policies count on several threads, the others run the sequential counting sort */
+template <typename ExecutionPolicy, typename Iterator>
+void counting_sort(const ExecutionPolicy&, Iterator begin, Iterator end)
+{
+    if constexpr (is_parallel_policy_v<ExecutionPolicy>)
+    {
+        parallel_counting_sort(begin, end);
+    }
+    else
+    {
+        counting_sort(begin, end, std::pmr::get_default_resource());
+    }
+}
+
+template <typename Iterator, typename KeyExtractor>
+void counting_sort(Iterator begin, Iterator end, KeyExtractor key_of)
+{
+    using value_type = std::iter_value_t<Iterator>;
+
+    const auto size = static_cast<std::size_t>(std::distance(begin, end));
+    auto [counts, min] = counting_histogram(begin, end, size, key_of, std::pmr::get_default_resource());
+    if (counts.empty())
+    {
+        /* Keys are too sparse to count them, fall back to a stable comparison sort */
+        std::vector<value_type> buffer(std::make_move_iterator(begin), std::make_move_iterator(end));
+        std::stable_sort(buffer.begin(), buffer.end(), [&](const auto& lhs, const auto& rhs)
+                         { return to_counting_key(std::invoke(key_of, lhs)) < to_counting_key(std::invoke(key_of, rhs)); });
+        std::move(buffer.begin(), buffer.end(), begin);
+        return;
+    }
+
+    /* Turn counts into starting offsets of the buckets */
+    std::size_t offset = 0;
+    for (auto& count : counts)
+    {
+        offset += std::exchange(count, offset);
+    }
+
+    /* Elements wait in the buffer while being put back, in input order so equal keys keep their order */
+    std::vector<value_type> buffer(std::make_move_iterator(begin), std::make_move_iterator(end));
+    if constexpr (std::random_access_iterator<Iterator>)
+    {
+        for (auto& element : buffer)
+        {
+            const auto bucket = static_cast<std::size_t>(to_counting_key(std::invoke(key_of, element)) - min);
+            begin[static_cast<std::ptrdiff_t>(counts[bucket]++)] = std::move(element);
+        }
+    }
+    else
+    {
+        std::vector<Iterator> positions;
+        positions.reserve(size);
+        for (auto it = begin; it != end; ++it)
+        {
+            positions.push_back(it);
+        }
+        for (auto& element : buffer)
+        {
+            const auto bucket = static_cast<std::size_t>(to_counting_key(std::invoke(key_of, element)) - min);
+            *positions[counts[bucket]++] = std::move(element);
+        }
+    }
+}
 }  // namespace detail
+
+template <typename Range, typename = detail::enable_if_counting_sortable_t<Range>>
+void counting_sort(Range& range)
+{
+    auto begin = detail::unwrap(std::begin(range));
+    auto end = detail::unwrap(std::end(range));
+
+    if (begin == end)
+    {
+        return;
+    }
+
+    detail::counting_sort(begin, end, std::pmr::get_default_resource());
+}
+
+/* Takes the histogram from the given resource, without enough memory it falls back to radix_sort and then to quick_sort */
+template <typename Range, typename = detail::enable_if_counting_sortable_t<Range>>
+void counting_sort(Range& range, std::pmr::memory_resource* resource)
+{
+    auto begin = detail::unwrap(std::begin(range));
+    auto end = detail::unwrap(std::end(range));
+
+    if (begin == end)
+    {
+        return;
+    }
+
+    detail::counting_sort(begin, end, resource);
+}
+
+/* Never allocates, the histogram is taken from the given memory */
+template <typename Range, typename = detail::enable_if_counting_sortable_t<Range>>
+void counting_sort(Range& range, std::span<std::byte> scratch)
+{
+    detail::scratch_resource resource{scratch};
+    counting_sort(range, &resource);
+}
+
+/* Stable sort by a small integer or enum key, e.g. a status code of the record */
+template <typename Range, typename KeyExtractor, typename = detail::enable_if_counting_sortable_by_t<Range, KeyExtractor>>
+void counting_sort(Range& range, KeyExtractor key_of)
+{
+    auto begin = detail::unwrap(std::begin(range));
+    auto end = detail::unwrap(std::end(range));
+
+    if (begin == end)
+    {
+        return;
+    }
+
+    detail::counting_sort(begin, end, key_of);
+}
+
+/* The policies are described in detail/execution.h */
+template <typename ExecutionPolicy, typename Range, typename = detail::enable_if_execution_policy_t<ExecutionPolicy, Range>,
+          typename = detail::enable_if_counting_sortable_t<Range>>
+void counting_sort(ExecutionPolicy&& policy, Range& range)
+{
+    auto begin = detail::unwrap(std::begin(range));
+    auto end = detail::unwrap(std::end(range));
+
+    if (begin == end)
+    {
+        return;
+    }
+
+    detail::counting_sort(policy, begin, end);
+}
 }  // namespace algorithm
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+namespace algorithm
+{
+namespace detail
+{
+/*
+ * Uninitialized storage for sorts that need extra memory, elements are constructed and destroyed by the sort itself.
+ * Allocation never throws: when the resource can't provide the requested size, the buffer asks for half of it,
+ * down to the minimal size, and stays empty if even that is not available. Sorts then fall back to algorithms using less memory.
+ * In constant evaluation memory resources can't be used, the buffer takes the whole size from std::allocator instead.
+ */
+template <typename T>
+class temporary_buffer
+{
+    public:
+    constexpr temporary_buffer(std::size_t size, std::pmr::memory_resource* resource, std::size_t minimal_size)
+        : resource_(resource), data_(nullptr), size_(0)
+    {
+        if (std::is_constant_evaluated())
+        {
+            data_ = std::allocator<T>{}.allocate(size);
+            size_ = size;
+            return;
+        }
+
+        for (; size >= minimal_size && size > 0; size /= 2)
+        {
+            try
+            {
+                data_ = static_cast<T*>(resource_->allocate(size * sizeof(T), alignof(T)));
+                size_ = size;
+                return;
+            }
+            catch (const std::bad_alloc&)
+            {
+            }
+        }
+    }
+
+    constexpr temporary_buffer(std::size_t size, std::pmr::memory_resource* resource) : temporary_buffer(size, resource, size) {}
+
+    /* The buffer owns raw memory only, so it can't be copied or moved */
+    temporary_buffer(const temporary_buffer<T>&) = delete;
+    temporary_buffer(temporary_buffer<T>&&) = delete;
+
+    temporary_buffer<T>& operator=(const temporary_buffer<T>&) = delete;
+    temporary_buffer<T>& operator=(temporary_buffer<T>&&) = delete;
+
+    constexpr ~temporary_buffer()
+    {
+        if (std::is_constant_evaluated())
+        {
+            std::allocator<T>{}.deallocate(data_, size_);
+        }
+        else if (data_)
+        {
+            resource_->deallocate(data_, size_ * sizeof(T), alignof(T));
+        }
+    }
+
+    constexpr T* data() const
+    {
+        return data_;
+    }
+
+    constexpr std::size_t size() const
+    {
+        return size_;
+    }
+
+    private:
+    std::pmr::memory_resource* resource_;
+    T* data_;
+    std::size_t size_;
+};
+
+/* The default resource for sorts that can also run in constant evaluation, where it is never used */
+constexpr std::pmr::memory_resource* default_resource()
+{
+    return std::is_constant_evaluated() ? nullptr : std::pmr::get_default_resource();
+}
+
+/* Same as std::uninitialized_move, which is not constexpr in C++20 */
+template <typename Input, typename T>
+constexpr T* move_construct(Input first, Input last, T* output)
+{
+    if (std::is_constant_evaluated())
+    {
+        for (; first != last; ++first, ++output)
+        {
+            std::construct_at(output, std::ranges::iter_move(first));
+        }
+        return output;
+    }
+    return std::uninitialized_move(first, last, output);
+}
+
+/* Serves allocations from the caller's memory only, running out of it makes the allocation fail instead of calling malloc */
+class scratch_resource : public std::pmr::monotonic_buffer_resource
+{
+    public:
+    explicit scratch_resource(std::span<std::byte> scratch)
+        : std::pmr::monotonic_buffer_resource(scratch.data(), scratch.size(), std::pmr::null_memory_resource())
+    {
+    }
+};
+}  // namespace detail
+}  // namespace algorithm
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <functional>
+#include <type_traits>
+
+/*
+ * Sorts take a comparator and a projection like the std::ranges algorithms, but internally they only ever call one
+ * binary predicate. The projection is folded into it here, and without a projection the comparator is passed on as is,
+ * so the default std::less<> inlines down to the plain operator<.
+ */
+namespace algorithm
+{
+namespace detail
+{
+template <typename Compare, typename Projection>
+struct projected_compare
+{
+    template <typename Left, typename Right>
+    constexpr bool operator()(Left&& lhs, Right&& rhs)
+    {
+        return std::invoke(comp, std::invoke(proj, std::forward<Left>(lhs)), std::invoke(proj, std::forward<Right>(rhs)));
+    }
+
+    [[no_unique_address]] Compare comp;
+    [[no_unique_address]] Projection proj;
+};
+
+template <typename Compare, typename Projection>
+constexpr auto make_compare(Compare comp, Projection proj)
+{
+    if constexpr (std::is_same_v<Projection, std::identity>)
+    {
+        return comp;
+    }
+    else
+    {
+        return projected_compare<Compare, Projection>{comp, proj};
+    }
+}
+
+/* Vectorized kernels and register networks order numbers by operator< themselves, so they serve only these comparators */
+template <typename Compare>
+constexpr bool is_natural_order_v = std::is_same_v<Compare, std::less<>> || std::is_same_v<Compare, std::ranges::less>;
+}  // namespace detail
+}  // namespace algorithm
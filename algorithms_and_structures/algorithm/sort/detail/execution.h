@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <execution>
+#include <type_traits>
+#include "type_traits.h"
+
+/*
+ * Standard execution policies select the implementation of a sort:
+ * - seq runs the plain sequential sort,
+ * - unseq runs a sequential variant whose inner loops have no dependencies between iterations, so they vectorize,
+ * - par and par_unseq split the work between the threads of the current TBB task arena.
+ * Small ranges are sorted sequentially under every policy, threads would cost more than they save there.
+ */
+namespace algorithm
+{
+namespace detail
+{
+template <typename ExecutionPolicy>
+constexpr bool is_execution_policy_v = std::is_execution_policy_v<std::remove_cvref_t<ExecutionPolicy>>;
+
+template <typename ExecutionPolicy>
+constexpr bool is_parallel_policy_v = std::is_same_v<std::remove_cvref_t<ExecutionPolicy>, std::execution::parallel_policy> ||
+                                      std::is_same_v<std::remove_cvref_t<ExecutionPolicy>, std::execution::parallel_unsequenced_policy>;
+
+template <typename ExecutionPolicy>
+constexpr bool is_unsequenced_policy_v = std::is_same_v<std::remove_cvref_t<ExecutionPolicy>, std::execution::unsequenced_policy> ||
+                                         std::is_same_v<std::remove_cvref_t<ExecutionPolicy>, std::execution::parallel_unsequenced_policy>;
+
+/*
+ * The radix, counting and bucket sorts pass over every element only a few times, and each parallel pass ends with the
+ * threads waiting for each other; below this size the waiting costs more than the threads save.
+ */
+constexpr std::size_t parallel_distribution_sort_threshold = std::size_t{1} << 16;
+
+template <typename ExecutionPolicy, typename Range>
+using enable_if_execution_policy_t = std::enable_if_t<is_execution_policy_v<ExecutionPolicy> && is_sortable_v<Range>, bool>;
+
+template <typename ExecutionPolicy, typename Range, typename Compare, typename Projection>
+using enable_if_execution_policy_by_t =
+    std::enable_if_t<is_execution_policy_v<ExecutionPolicy> && is_sortable_by_v<Range, Compare, Projection>, bool>;
+}  // namespace detail
+}  // namespace algorithm
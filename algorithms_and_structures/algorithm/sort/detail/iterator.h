@@ -0,0 +1,27 @@
+#pragma once
+
+#include <iterator>
+#include <memory>
+
+namespace algorithm
+{
+namespace detail
+{
+/*
+ * Contiguous iterators are replaced by raw pointers before sorting, so every sort over a vector or an array runs
+ * the same pointer loops, without the iterator wrappers (and their checks in debug builds).
+ */
+template <typename Iterator>
+constexpr auto unwrap(Iterator iterator)
+{
+    if constexpr (std::contiguous_iterator<Iterator>)
+    {
+        return std::to_address(iterator);
+    }
+    else
+    {
+        return iterator;
+    }
+}
+}  // namespace detail
+}  // namespace algorithm
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <utility>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_invoke.h>
+#include <tbb/task_arena.h>
+#include "buffer.h"
+
+/* Merging shared by the merge based sorts, sequential and split between threads */
+namespace algorithm
+{
+namespace detail
+{
+/* Halves above this size are sorted as separate tasks, and merges above it are split between threads */
+constexpr std::ptrdiff_t parallel_merge_sort_threshold = std::ptrdiff_t{1} << 13;
+
+template <typename Input1, typename Input2, typename Output, typename Compare>
+constexpr Output move_merge(Input1 left, Input1 left_end, Input2 right, Input2 right_end, Output current, Compare& comp)
+{
+    while (left != left_end && right != right_end)
+    {
+        /* Take from the right half only if it is strictly smaller, so equal elements keep their order */
+        if (comp(*right, *left))
+        {
+            *current = std::ranges::iter_move(right);
+            ++right;
+        }
+        else
+        {
+            *current = std::ranges::iter_move(left);
+            ++left;
+        }
+        ++current;
+    }
+
+    /* Some elements could left so move them to the output */
+    current = std::move(left, left_end, current);
+    return std::move(right, right_end, current);
+}
+
+/*
+ * Merge path co-ranking: the number of elements the first `diagonal` elements of the merged output take from the left run.
+ * Binary search along the diagonal, consistent with move_merge, which takes equal elements from the left run first.
+ */
+template <typename Left, typename Right, typename Compare>
+std::ptrdiff_t co_rank(std::ptrdiff_t diagonal, Left left, std::ptrdiff_t left_size, Right right, std::ptrdiff_t right_size, Compare& comp)
+{
+    auto low = std::max<std::ptrdiff_t>(0, diagonal - right_size);
+    auto high = std::min(diagonal, left_size);
+    while (low < high)
+    {
+        const auto middle = low + (high - low) / 2;
+        if (comp(right[diagonal - middle - 1], left[middle]))
+        {
+            high = middle;
+        }
+        else
+        {
+            low = middle + 1;
+        }
+    }
+    return low;
+}
+
+/* Cuts the output into equal parts, finds where every part starts in both runs and merges the parts on separate threads */
+template <typename Left, typename Right, typename Output, typename Compare>
+void parallel_move_merge(Left left, std::ptrdiff_t left_size, Right right, std::ptrdiff_t right_size, Output output, Compare& comp)
+{
+    const auto size = left_size + right_size;
+    const auto parts = (size + parallel_merge_sort_threshold - 1) / parallel_merge_sort_threshold;
+    if (parts < 2)
+    {
+        move_merge(left, left + left_size, right, right + right_size, output, comp);
+        return;
+    }
+
+    tbb::parallel_for(std::ptrdiff_t{0}, parts,
+                      [&](std::ptrdiff_t part)
+                      {
+                          const auto first = size * part / parts;
+                          const auto last = size * (part + 1) / parts;
+                          const auto left_first = co_rank(first, left, left_size, right, right_size, comp);
+                          const auto left_last = co_rank(last, left, left_size, right, right_size, comp);
+                          move_merge(left + left_first, left + left_last, right + (first - left_first), right + (last - left_last), output + first,
+                                     comp);
+                      });
+}
+
+/*
+ * Sorts the elements at from, the result ends up at from when in_place is set and at to otherwise. Both hold size elements,
+ * the halves are sorted into the other one, so every merge moves the elements across once and no level copies them back.
+ * Ranges of at most leaf_size elements are sorted in place by sort_leaf.
+ */
+template <typename Input, typename Output, typename Compare, typename SortLeaf>
+void parallel_merge_sort(Input from, Output to, std::ptrdiff_t size, bool in_place, Compare& comp, std::ptrdiff_t leaf_size, SortLeaf& sort_leaf)
+{
+    if (size <= leaf_size)
+    {
+        sort_leaf(from, from + size);
+        if (!in_place)
+        {
+            std::move(from, from + size, to);
+        }
+        return;
+    }
+
+    const auto left_size = size / 2;
+    const auto right_size = size - left_size;
+    const auto sort_left = [&] { parallel_merge_sort(from, to, left_size, !in_place, comp, leaf_size, sort_leaf); };
+    const auto sort_right = [&] { parallel_merge_sort(from + left_size, to + left_size, right_size, !in_place, comp, leaf_size, sort_leaf); };
+    if (size > parallel_merge_sort_threshold)
+    {
+        tbb::parallel_invoke(sort_left, sort_right);
+    }
+    else
+    {
+        sort_left();
+        sort_right();
+    }
+
+    if (in_place)
+    {
+        parallel_move_merge(to, left_size, to + left_size, right_size, from, comp);
+    }
+    else
+    {
+        parallel_move_merge(from, left_size, from + left_size, right_size, to, comp);
+    }
+}
+
+/*
+ * Runs the sort on the threads of the current task arena if it has more than one and a buffer for the whole range is available,
+ * returns false without touching the range otherwise
+ */
+template <typename Iterator, typename Compare, typename SortLeaf>
+bool parallel_merge_sort(Iterator begin, std::ptrdiff_t size, std::pmr::memory_resource* resource, Compare& comp, std::ptrdiff_t leaf_size,
+                         SortLeaf sort_leaf)
+{
+    using value_type = std::iter_value_t<Iterator>;
+
+    if (size <= parallel_merge_sort_threshold || tbb::this_task_arena::max_concurrency() < 2)
+    {
+        return false;
+    }
+
+    temporary_buffer<value_type> buffer(static_cast<std::size_t>(size), resource);
+    if (buffer.size() == 0)
+    {
+        return false;
+    }
+
+    /* The range is moved into the buffer first, so both sides always hold constructed elements */
+    const tbb::blocked_range<std::ptrdiff_t> range{0, size, parallel_merge_sort_threshold};
+    tbb::parallel_for(range, [&](const auto& part)
+                      { std::uninitialized_move(begin + part.begin(), begin + part.end(), buffer.data() + part.begin()); });
+    parallel_merge_sort(buffer.data(), begin, size, false, comp, leaf_size, sort_leaf);
+    tbb::parallel_for(range, [&](const auto& part) { std::destroy(buffer.data() + part.begin(), buffer.data() + part.end()); });
+    return true;
+}
+}  // namespace detail
+}  // namespace algorithm
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace algorithm
+{
+namespace detail
+{
+/*
+ * Access to the elements of a range by their index. Random access iterators are just advanced,
+ * iterators of other ranges are collected up front, so every access is still constant time.
+ */
+template <typename Iterator>
+auto index_positions(Iterator begin, std::size_t size)
+{
+    if constexpr (std::random_access_iterator<Iterator>)
+    {
+        return [begin](std::size_t index) { return std::next(begin, static_cast<std::ptrdiff_t>(index)); };
+    }
+    else
+    {
+        std::vector<Iterator> positions;
+        positions.reserve(size);
+        for (std::size_t index = 0; index < size; ++index, ++begin)
+        {
+            positions.push_back(begin);
+        }
+        return [positions = std::move(positions)](std::size_t index) { return positions[index]; };
+    }
+}
+
+/*
+ * Moves the element from position order[i] to position i for every i, in place: every cycle of the permutation is
+ * walked once with a single element held aside, so each element is moved exactly once plus one move per cycle.
+ * Visited positions are marked by making them fixed points, which leaves the order as the identity.
+ * Several ranges are permuted together in the same walk, their elements are reached through the given accessors.
+ */
+template <typename... Position>
+void apply_permutation(std::span<std::size_t> order, Position&... position)
+{
+    for (std::size_t start = 0; start < order.size(); ++start)
+    {
+        if (order[start] == start)
+        {
+            continue;
+        }
+
+        std::tuple<std::remove_cvref_t<decltype(std::ranges::iter_move(position(start)))>...> values{std::ranges::iter_move(position(start))...};
+        auto hole = start;
+        while (order[hole] != start)
+        {
+            const auto next = order[hole];
+            ((*position(hole) = std::ranges::iter_move(position(next))), ...);
+            order[hole] = hole;
+            hole = next;
+        }
+        std::apply([&](auto&... value) { ((*position(hole) = std::move(value)), ...); }, values);
+        order[hole] = hole;
+    }
+}
+}  // namespace detail
+}  // namespace algorithm
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <type_traits>
+
+/*
+ * Vectorized kernels are written with intrinsics for x86-64. They are compiled for their instruction set with the target
+ * attribute, so the rest of the code does not need -mavx2 and the kernels are only called when the CPU supports them.
+ */
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define ALGORITHM_SORT_SIMD 1
+#else
+#define ALGORITHM_SORT_SIMD 0
+#endif
+
+namespace algorithm
+{
+namespace detail
+{
+/* Element types the kernels handle: 32 and 64 bit signed integers and IEEE floats */
+template <typename T>
+constexpr bool is_simd_value_v = std::is_same_v<T, float> || std::is_same_v<T, double> ||
+                                 (std::is_integral_v<T> && std::is_signed_v<T> && (sizeof(T) == 4 || sizeof(T) == 8));
+}  // namespace detail
+}  // namespace algorithm
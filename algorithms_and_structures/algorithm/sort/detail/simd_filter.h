@@ -0,0 +1,145 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+
+#include "simd.h"
+
+/*
+ * Vectorized search for the first element smaller than a threshold in a contiguous range of 32 and 64 bit signed integers,
+ * floats and doubles. Selections keep their best elements in a heap and compare every other element with its root, which
+ * once the heap fills up almost never lets an element in. The kernels compare four vectors at once and only look at single
+ * elements in the block where some element passed, so the common case costs a few instructions per vector.
+ */
+namespace algorithm
+{
+namespace detail
+{
+template <typename Iterator>
+constexpr bool is_simd_filterable_v = ALGORITHM_SORT_SIMD && std::contiguous_iterator<Iterator> &&
+                                      is_simd_value_v<std::iter_value_t<Iterator>>;
+
+/* First element of [begin, end) smaller than the threshold, or end */
+template <typename T>
+using simd_find_below_kernel_t = const T* (*)(const T*, const T*, T);
+
+#if ALGORITHM_SORT_SIMD
+template <typename T>
+__attribute__((target("avx2"))) const T* avx2_find_below(const T* begin, const T* end, T threshold)
+{
+    constexpr std::ptrdiff_t width = 32 / sizeof(T);
+
+    /* All lanes set for elements smaller than the threshold */
+    const auto below = [threshold](const T* source) __attribute__((target("avx2")))
+    {
+        if constexpr (std::is_same_v<T, float>)
+        {
+            return _mm256_castps_si256(_mm256_cmp_ps(_mm256_loadu_ps(source), _mm256_set1_ps(threshold), _CMP_LT_OQ));
+        }
+        else if constexpr (std::is_same_v<T, double>)
+        {
+            return _mm256_castpd_si256(_mm256_cmp_pd(_mm256_loadu_pd(source), _mm256_set1_pd(threshold), _CMP_LT_OQ));
+        }
+        else if constexpr (sizeof(T) == 4)
+        {
+            const auto vector = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source));
+            return _mm256_cmpgt_epi32(_mm256_set1_epi32(static_cast<std::int32_t>(threshold)), vector);
+        }
+        else
+        {
+            const auto vector = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source));
+            return _mm256_cmpgt_epi64(_mm256_set1_epi64x(static_cast<std::int64_t>(threshold)), vector);
+        }
+    };
+
+    auto current = begin;
+    while (end - current >= 4 * width)
+    {
+        const auto any = _mm256_or_si256(_mm256_or_si256(below(current), below(current + width)),
+                                         _mm256_or_si256(below(current + 2 * width), below(current + 3 * width)));
+        if (!_mm256_testz_si256(any, any))
+        {
+            break;
+        }
+        current += 4 * width;
+    }
+
+    /* The block holding the first smaller element, or the tail shorter than a block, is searched element by element */
+    return std::find_if(current, end, [threshold](T value) { return value < threshold; });
+}
+
+template <typename T>
+__attribute__((target("avx512f"))) const T* avx512_find_below(const T* begin, const T* end, T threshold)
+{
+    constexpr std::ptrdiff_t width = 64 / sizeof(T);
+
+    /* One bit per lane, set for elements smaller than the threshold */
+    const auto below = [threshold](const T* source) __attribute__((target("avx512f")))
+    {
+        if constexpr (std::is_same_v<T, float>)
+        {
+            return static_cast<unsigned>(_mm512_cmp_ps_mask(_mm512_loadu_ps(source), _mm512_set1_ps(threshold), _CMP_LT_OQ));
+        }
+        else if constexpr (std::is_same_v<T, double>)
+        {
+            return static_cast<unsigned>(_mm512_cmp_pd_mask(_mm512_loadu_pd(source), _mm512_set1_pd(threshold), _CMP_LT_OQ));
+        }
+        else if constexpr (sizeof(T) == 4)
+        {
+            const auto vector = _mm512_loadu_si512(source);
+            return static_cast<unsigned>(_mm512_cmplt_epi32_mask(vector, _mm512_set1_epi32(static_cast<std::int32_t>(threshold))));
+        }
+        else
+        {
+            const auto vector = _mm512_loadu_si512(source);
+            return static_cast<unsigned>(_mm512_cmplt_epi64_mask(vector, _mm512_set1_epi64(static_cast<std::int64_t>(threshold))));
+        }
+    };
+
+    auto current = begin;
+    while (end - current >= 4 * width)
+    {
+        if ((below(current) | below(current + width) | below(current + 2 * width) | below(current + 3 * width)) != 0)
+        {
+            break;
+        }
+        current += 4 * width;
+    }
+    return std::find_if(current, end, [threshold](T value) { return value < threshold; });
+}
+
+/* Asks the CPU for the best kernel, or none */
+template <typename T>
+simd_find_below_kernel_t<T> select_simd_find_below()
+{
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+    {
+        return avx512_find_below<T>;
+    }
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return avx2_find_below<T>;
+    }
+    return nullptr;
+}
+#else
+template <typename T>
+simd_find_below_kernel_t<T> select_simd_find_below()
+{
+    return nullptr;
+}
+#endif
+
+/* The kernel is selected on the first use and cached */
+template <typename T>
+simd_find_below_kernel_t<T> simd_find_below_kernel()
+{
+    static const auto kernel = select_simd_find_below<T>();
+    return kernel;
+}
+}  // namespace detail
+}  // namespace algorithm
@@ -0,0 +1,268 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "simd.h"
+
+/*
+ * Vectorized partition for contiguous ranges of 32 and 64 bit signed integers, floats and doubles.
+ * A whole vector is compared with the pivot at once, then the smaller elements are written to the left end and the others
+ * to the right end of the free space. AVX-512 does it with compress stores, AVX2 shuffles the vector with a permutation
+ * looked up by the comparison mask and stores it on both sides. The kernel is chosen once at runtime by the CPU features,
+ * so the binary does not have to be compiled for them.
+ */
+namespace algorithm
+{
+namespace detail
+{
+/* Smaller partitions don't fill enough vectors to pay for the setup */
+constexpr std::ptrdiff_t simd_partition_minimal_size = 64;
+
+template <typename Iterator>
+constexpr bool is_simd_partitionable_v = ALGORITHM_SORT_SIMD && std::contiguous_iterator<Iterator> &&
+                                         is_simd_value_v<std::iter_value_t<Iterator>>;
+
+/* Partitions [begin, end) around the pivot in the last position, same contract as the scalar partition */
+template <typename T>
+using simd_partition_kernel_t = T* (*)(T*, T*);
+
+/* Distributes the elements which did not fill a whole vector, branchless: each is written to both ends and one of them advances */
+template <typename T>
+void split_scalar(const T* source, std::ptrdiff_t size, T pivot, T*& left, T*& right)
+{
+    for (std::ptrdiff_t index = 0; index < size; ++index)
+    {
+        const auto value = source[index];
+        const bool smaller = value < pivot;
+        *left = value;
+        *(right - 1) = value;
+        left += smaller;
+        right -= !smaller;
+    }
+}
+
+/*
+ * The loop common to both kernels. The first and the last vector are copied aside, which leaves free space of two vectors:
+ * [left, read_left) and [read_right, right). Every step reads a vector from the side with less free space, so writing
+ * it back never overtakes unread elements. Elements copied aside and the tail shorter than a vector are written last.
+ */
+template <typename T, std::ptrdiff_t Width, typename Split>
+inline __attribute__((always_inline)) T* simd_partition_loop(T* begin, T* end, Split split)
+{
+    auto last = end - 1;
+    const auto pivot = *last;
+
+    T aside[3 * Width];
+    std::copy(begin, begin + Width, aside);
+    std::copy(last - Width, last, aside + Width);
+
+    auto read_left = begin + Width;
+    auto read_right = last - Width;
+    auto left = begin;
+    auto right = last;
+    while (read_right - read_left >= Width)
+    {
+        const T* source;
+        if (read_left - left <= right - read_right)
+        {
+            source = read_left;
+            read_left += Width;
+        }
+        else
+        {
+            read_right -= Width;
+            source = read_right;
+        }
+        split(source, left, right);
+    }
+
+    const auto tail = read_right - read_left;
+    std::copy(read_left, read_right, aside + 2 * Width);
+    split_scalar(aside, 2 * Width + tail, pivot, left, right);
+
+    /* Every element before left is smaller than the pivot, so the pivot belongs right there */
+    std::swap(*left, *last);
+    return left;
+}
+
+#if ALGORITHM_SORT_SIMD
+/* Indices of the 32 bit parts for _mm256_permutevar8x32, selected lanes of the mask first, then the others */
+template <std::size_t Lanes>
+constexpr auto make_permutation_table()
+{
+    constexpr std::size_t parts = 8 / Lanes;
+    std::array<std::array<std::uint32_t, 8>, (std::size_t{1} << Lanes)> table{};
+    for (std::size_t mask = 0; mask < table.size(); ++mask)
+    {
+        std::size_t position = 0;
+        for (const bool selected : {true, false})
+        {
+            for (std::size_t lane = 0; lane < Lanes; ++lane)
+            {
+                if (((mask >> lane) & 1) == selected)
+                {
+                    for (std::size_t part = 0; part < parts; ++part)
+                    {
+                        table[mask][position++] = static_cast<std::uint32_t>(lane * parts + part);
+                    }
+                }
+            }
+        }
+    }
+    return table;
+}
+
+alignas(32) inline constexpr auto avx2_permutation_table_32 = make_permutation_table<8>();
+alignas(32) inline constexpr auto avx2_permutation_table_64 = make_permutation_table<4>();
+
+template <typename T>
+__attribute__((target("avx2"))) T* avx2_partition(T* begin, T* end)
+{
+    constexpr std::ptrdiff_t width = 32 / sizeof(T);
+    const auto pivot = *(end - 1);
+
+    const auto split = [pivot](const T* source, T*& left, T*& right) __attribute__((target("avx2")))
+    {
+        /* Broadcasting the pivot is hoisted out of the loop once this is inlined */
+        __m256i pivot_vector;
+        if constexpr (std::is_same_v<T, float>)
+        {
+            pivot_vector = _mm256_castps_si256(_mm256_set1_ps(pivot));
+        }
+        else if constexpr (std::is_same_v<T, double>)
+        {
+            pivot_vector = _mm256_castpd_si256(_mm256_set1_pd(pivot));
+        }
+        else if constexpr (sizeof(T) == 4)
+        {
+            pivot_vector = _mm256_set1_epi32(static_cast<std::int32_t>(pivot));
+        }
+        else
+        {
+            pivot_vector = _mm256_set1_epi64x(static_cast<std::int64_t>(pivot));
+        }
+
+        const auto vector = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source));
+
+        /* One bit per lane, set for elements smaller than the pivot */
+        unsigned mask;
+        if constexpr (std::is_same_v<T, float>)
+        {
+            const auto compared = _mm256_cmp_ps(_mm256_castsi256_ps(vector), _mm256_castsi256_ps(pivot_vector), _CMP_LT_OQ);
+            mask = static_cast<unsigned>(_mm256_movemask_ps(compared));
+        }
+        else if constexpr (std::is_same_v<T, double>)
+        {
+            const auto compared = _mm256_cmp_pd(_mm256_castsi256_pd(vector), _mm256_castsi256_pd(pivot_vector), _CMP_LT_OQ);
+            mask = static_cast<unsigned>(_mm256_movemask_pd(compared));
+        }
+        else if constexpr (sizeof(T) == 4)
+        {
+            mask = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(pivot_vector, vector))));
+        }
+        else
+        {
+            mask = static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(pivot_vector, vector))));
+        }
+
+        const auto& permutation = sizeof(T) == 4 ? avx2_permutation_table_32[mask] : avx2_permutation_table_64[mask];
+        const auto packed = _mm256_permutevar8x32_epi32(vector, _mm256_load_si256(reinterpret_cast<const __m256i*>(permutation.data())));
+
+        /* Both sides have room for a whole vector, the excess is free space overwritten later */
+        const auto smaller = static_cast<std::ptrdiff_t>(std::popcount(mask));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(left), packed);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(right - width), packed);
+        left += smaller;
+        right -= width - smaller;
+    };
+    return simd_partition_loop<T, width>(begin, end, split);
+}
+
+template <typename T>
+__attribute__((target("avx512f"))) T* avx512_partition(T* begin, T* end)
+{
+    constexpr std::ptrdiff_t width = 64 / sizeof(T);
+    const auto pivot = *(end - 1);
+
+    const auto split = [pivot](const T* source, T*& left, T*& right) __attribute__((target("avx512f")))
+    {
+        /* Compress stores write only the selected lanes, packed together */
+        std::ptrdiff_t smaller;
+        if constexpr (std::is_same_v<T, float>)
+        {
+            const auto vector = _mm512_loadu_ps(source);
+            const auto mask = _mm512_cmp_ps_mask(vector, _mm512_set1_ps(pivot), _CMP_LT_OQ);
+            smaller = std::popcount(static_cast<unsigned>(mask));
+            _mm512_mask_compressstoreu_ps(left, mask, vector);
+            _mm512_mask_compressstoreu_ps(right - (width - smaller), static_cast<__mmask16>(~mask), vector);
+        }
+        else if constexpr (std::is_same_v<T, double>)
+        {
+            const auto vector = _mm512_loadu_pd(source);
+            const auto mask = _mm512_cmp_pd_mask(vector, _mm512_set1_pd(pivot), _CMP_LT_OQ);
+            smaller = std::popcount(static_cast<unsigned>(mask));
+            _mm512_mask_compressstoreu_pd(left, mask, vector);
+            _mm512_mask_compressstoreu_pd(right - (width - smaller), static_cast<__mmask8>(~mask), vector);
+        }
+        else if constexpr (sizeof(T) == 4)
+        {
+            const auto vector = _mm512_loadu_si512(source);
+            const auto mask = _mm512_cmplt_epi32_mask(vector, _mm512_set1_epi32(static_cast<std::int32_t>(pivot)));
+            smaller = std::popcount(static_cast<unsigned>(mask));
+            _mm512_mask_compressstoreu_epi32(left, mask, vector);
+            _mm512_mask_compressstoreu_epi32(right - (width - smaller), static_cast<__mmask16>(~mask), vector);
+        }
+        else
+        {
+            const auto vector = _mm512_loadu_si512(source);
+            const auto mask = _mm512_cmplt_epi64_mask(vector, _mm512_set1_epi64(static_cast<std::int64_t>(pivot)));
+            smaller = std::popcount(static_cast<unsigned>(mask));
+            _mm512_mask_compressstoreu_epi64(left, mask, vector);
+            _mm512_mask_compressstoreu_epi64(right - (width - smaller), static_cast<__mmask8>(~mask), vector);
+        }
+        left += smaller;
+        right -= width - smaller;
+    };
+    return simd_partition_loop<T, width>(begin, end, split);
+}
+
+/* Asks the CPU (cpuid, plus the OS support of the wider registers) for the best kernel, or none */
+template <typename T>
+simd_partition_kernel_t<T> select_simd_partition()
+{
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+    {
+        return avx512_partition<T>;
+    }
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return avx2_partition<T>;
+    }
+    return nullptr;
+}
+#else
+template <typename T>
+simd_partition_kernel_t<T> select_simd_partition()
+{
+    return nullptr;
+}
+#endif
+
+/* The kernel is selected on the first use and cached */
+template <typename T>
+simd_partition_kernel_t<T> simd_partition_kernel()
+{
+    static const auto kernel = select_simd_partition<T>();
+    return kernel;
+}
+}  // namespace detail
+}  // namespace algorithm
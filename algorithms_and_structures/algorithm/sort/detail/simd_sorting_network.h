@@ -0,0 +1,218 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include "simd.h"
+
+/*
+ * Bitonic sorting networks working inside a single vector register. Each step pairs every lane with the lane at the given
+ * distance (a permutation), takes the minimum and the maximum of both, and blends them so the lower lane of an ascending
+ * block keeps the minimum. Short ranges are padded with the largest value, which stays at the end.
+ */
+namespace algorithm
+{
+namespace detail
+{
+/* Lanes of a block which keep the minimum in the given step of a bitonic sort, one bit per lane */
+constexpr std::uint32_t bitonic_minimum_lanes(std::size_t lanes, std::size_t block, std::size_t distance)
+{
+    std::uint32_t mask = 0;
+    for (std::size_t lane = 0; lane < lanes; ++lane)
+    {
+        if (((lane & distance) == 0) == ((lane & block) == 0))
+        {
+            mask |= std::uint32_t{1} << lane;
+        }
+    }
+    return mask;
+}
+
+/* Fills the lanes past the end of a short range, it is not smaller than any element so it stays behind them */
+template <typename T>
+constexpr T simd_network_padding_v = std::numeric_limits<T>::has_infinity ? std::numeric_limits<T>::infinity() : std::numeric_limits<T>::max();
+
+#if ALGORITHM_SORT_SIMD
+template <typename T, std::size_t Block, std::size_t Distance>
+__attribute__((target("avx2"))) inline __m256i avx2_bitonic_step(__m256i vector)
+{
+    constexpr int d = static_cast<int>(Distance);
+    constexpr int keep_minimum = static_cast<int>(bitonic_minimum_lanes(8, Block, Distance));
+    const auto partner = _mm256_permutevar8x32_epi32(vector, _mm256_setr_epi32(0 ^ d, 1 ^ d, 2 ^ d, 3 ^ d, 4 ^ d, 5 ^ d, 6 ^ d, 7 ^ d));
+
+    __m256i minimum;
+    __m256i maximum;
+    if constexpr (std::is_same_v<T, float>)
+    {
+        minimum = _mm256_castps_si256(_mm256_min_ps(_mm256_castsi256_ps(vector), _mm256_castsi256_ps(partner)));
+        maximum = _mm256_castps_si256(_mm256_max_ps(_mm256_castsi256_ps(vector), _mm256_castsi256_ps(partner)));
+    }
+    else
+    {
+        minimum = _mm256_min_epi32(vector, partner);
+        maximum = _mm256_max_epi32(vector, partner);
+    }
+    return _mm256_blend_epi32(maximum, minimum, keep_minimum);
+}
+
+/* Sorts N <= 8 elements of 32 bits in one AVX2 register */
+template <std::size_t N, typename T>
+__attribute__((target("avx2"))) void avx2_network_sort(T* data)
+{
+    static_assert(sizeof(T) == 4 && N <= 8, "AVX2 network sorts up to 8 elements of 32 bits");
+
+    __m256i vector;
+    if constexpr (N == 8)
+    {
+        vector = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+    }
+    else
+    {
+        constexpr int used = static_cast<int>((1u << N) - 1);
+        const auto mask = _mm256_setr_epi32(0 < N ? -1 : 0, 1 < N ? -1 : 0, 2 < N ? -1 : 0, 3 < N ? -1 : 0, 4 < N ? -1 : 0, 5 < N ? -1 : 0,
+                                            6 < N ? -1 : 0, 7 < N ? -1 : 0);
+        const auto loaded = _mm256_maskload_epi32(reinterpret_cast<const int*>(data), mask);
+        const auto padding = _mm256_set1_epi32(std::bit_cast<std::int32_t>(simd_network_padding_v<T>));
+        vector = _mm256_blend_epi32(padding, loaded, used);
+    }
+
+    vector = avx2_bitonic_step<T, 2, 1>(vector);
+    vector = avx2_bitonic_step<T, 4, 2>(vector);
+    vector = avx2_bitonic_step<T, 4, 1>(vector);
+    vector = avx2_bitonic_step<T, 8, 4>(vector);
+    vector = avx2_bitonic_step<T, 8, 2>(vector);
+    vector = avx2_bitonic_step<T, 8, 1>(vector);
+
+    if constexpr (N == 8)
+    {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(data), vector);
+    }
+    else
+    {
+        const auto mask = _mm256_setr_epi32(0 < N ? -1 : 0, 1 < N ? -1 : 0, 2 < N ? -1 : 0, 3 < N ? -1 : 0, 4 < N ? -1 : 0, 5 < N ? -1 : 0,
+                                            6 < N ? -1 : 0, 7 < N ? -1 : 0);
+        _mm256_maskstore_epi32(reinterpret_cast<int*>(data), mask, vector);
+    }
+}
+
+template <typename T, std::size_t Block, std::size_t Distance>
+__attribute__((target("avx512f"))) inline __m512i avx512_bitonic_step(__m512i vector)
+{
+    constexpr std::size_t lanes = 64 / sizeof(T);
+    constexpr auto keep_minimum = bitonic_minimum_lanes(lanes, Block, Distance);
+
+    if constexpr (sizeof(T) == 4)
+    {
+        constexpr int d = static_cast<int>(Distance);
+        const auto partner = _mm512_permutexvar_epi32(_mm512_setr_epi32(0 ^ d, 1 ^ d, 2 ^ d, 3 ^ d, 4 ^ d, 5 ^ d, 6 ^ d, 7 ^ d, 8 ^ d, 9 ^ d,
+                                                                         10 ^ d, 11 ^ d, 12 ^ d, 13 ^ d, 14 ^ d, 15 ^ d),
+                                                      vector);
+        const auto mask = static_cast<__mmask16>(keep_minimum);
+        if constexpr (std::is_same_v<T, float>)
+        {
+            const auto value = _mm512_castsi512_ps(vector);
+            const auto other = _mm512_castsi512_ps(partner);
+            return _mm512_castps_si512(_mm512_mask_blend_ps(mask, _mm512_max_ps(value, other), _mm512_min_ps(value, other)));
+        }
+        else
+        {
+            return _mm512_mask_blend_epi32(mask, _mm512_max_epi32(vector, partner), _mm512_min_epi32(vector, partner));
+        }
+    }
+    else
+    {
+        constexpr long long d = static_cast<long long>(Distance);
+        const auto partner = _mm512_permutexvar_epi64(_mm512_setr_epi64(0 ^ d, 1 ^ d, 2 ^ d, 3 ^ d, 4 ^ d, 5 ^ d, 6 ^ d, 7 ^ d), vector);
+        const auto mask = static_cast<__mmask8>(keep_minimum);
+        if constexpr (std::is_same_v<T, double>)
+        {
+            const auto value = _mm512_castsi512_pd(vector);
+            const auto other = _mm512_castsi512_pd(partner);
+            return _mm512_castpd_si512(_mm512_mask_blend_pd(mask, _mm512_max_pd(value, other), _mm512_min_pd(value, other)));
+        }
+        else
+        {
+            return _mm512_mask_blend_epi64(mask, _mm512_max_epi64(vector, partner), _mm512_min_epi64(vector, partner));
+        }
+    }
+}
+
+/* Sorts N <= 16 elements of 32 bits or N <= 8 elements of 64 bits in one AVX-512 register */
+template <std::size_t N, typename T>
+__attribute__((target("avx512f"))) void avx512_network_sort(T* data)
+{
+    constexpr std::size_t lanes = 64 / sizeof(T);
+    static_assert(N <= lanes, "AVX-512 network sorts up to one register of elements");
+
+    /* Masked loads and stores touch only the first N elements */
+    constexpr auto used = static_cast<std::uint32_t>((std::uint64_t{1} << N) - 1);
+    __m512i vector;
+    if constexpr (sizeof(T) == 4)
+    {
+        vector = _mm512_mask_loadu_epi32(_mm512_set1_epi32(std::bit_cast<std::int32_t>(simd_network_padding_v<T>)), static_cast<__mmask16>(used),
+                                         data);
+    }
+    else
+    {
+        vector = _mm512_mask_loadu_epi64(_mm512_set1_epi64(std::bit_cast<std::int64_t>(simd_network_padding_v<T>)), static_cast<__mmask8>(used),
+                                         data);
+    }
+
+    if constexpr (lanes == 16)
+    {
+        vector = avx512_bitonic_step<T, 2, 1>(vector);
+        vector = avx512_bitonic_step<T, 4, 2>(vector);
+        vector = avx512_bitonic_step<T, 4, 1>(vector);
+        vector = avx512_bitonic_step<T, 8, 4>(vector);
+        vector = avx512_bitonic_step<T, 8, 2>(vector);
+        vector = avx512_bitonic_step<T, 8, 1>(vector);
+        vector = avx512_bitonic_step<T, 16, 8>(vector);
+        vector = avx512_bitonic_step<T, 16, 4>(vector);
+        vector = avx512_bitonic_step<T, 16, 2>(vector);
+        vector = avx512_bitonic_step<T, 16, 1>(vector);
+        _mm512_mask_storeu_epi32(data, static_cast<__mmask16>(used), vector);
+    }
+    else
+    {
+        vector = avx512_bitonic_step<T, 2, 1>(vector);
+        vector = avx512_bitonic_step<T, 4, 2>(vector);
+        vector = avx512_bitonic_step<T, 4, 1>(vector);
+        vector = avx512_bitonic_step<T, 8, 4>(vector);
+        vector = avx512_bitonic_step<T, 8, 2>(vector);
+        vector = avx512_bitonic_step<T, 8, 1>(vector);
+        _mm512_mask_storeu_epi64(data, static_cast<__mmask8>(used), vector);
+    }
+}
+#endif
+
+/*
+ * Register networks are inlined into the callers, so they are only used when the whole program is compiled for the
+ * instruction set (-mavx2, -mavx512f or -march=native). Returns the number of elements one register sorts, 0 if none.
+ */
+template <typename T>
+constexpr std::size_t simd_network_lanes()
+{
+#if ALGORITHM_SORT_SIMD && defined(__AVX512F__)
+    return is_simd_value_v<T> ? 64 / sizeof(T) : 0;
+#elif ALGORITHM_SORT_SIMD && defined(__AVX2__)
+    return is_simd_value_v<T> && sizeof(T) == 4 ? 8 : 0;
+#else
+    return 0;
+#endif
+}
+
+template <std::size_t N, typename T>
+void simd_network_sort(T* data)
+{
+#if ALGORITHM_SORT_SIMD && defined(__AVX512F__)
+    avx512_network_sort<N>(data);
+#elif ALGORITHM_SORT_SIMD && defined(__AVX2__)
+    avx2_network_sort<N>(data);
+#else
+    static_assert(N == 0, "No register network for this instruction set");
+#endif
+}
+}  // namespace detail
+}  // namespace algorithm
@@ -1,16 +1,138 @@
 #pragma once
 
+#include <concepts>
+#include <functional>
+#include <iterator>
+#include <limits>
 #include "include/type_traits.h"
 
 namespace algorithm
 {
 namespace detail
 {
-/* Is comparable must be implemented */
+/* Is comparable must be implemented; anything without iterators, like an execution policy, is not sortable instead of ill-formed */
+template <typename Range, typename = void>
+struct is_sortable : std::false_type
+{
+};
+
+template <typename Range>
+struct is_sortable<Range, std::void_t<std_ext::iterator_t<Range>>>
+    : std::is_base_of<std::bidirectional_iterator_tag, typename std::iterator_traits<std_ext::iterator_t<Range>>::iterator_category>
+{
+};
+
+template <typename Range>
+constexpr bool is_sortable_v = is_sortable<Range>::value;
+
+/* Value type of a sortable range and a tag for anything else, so the traits of the value below stay false for non-ranges */
+struct no_sortable_value
+{
+};
+
+template <typename Range, typename = void>
+struct sortable_value
+{
+    using type = no_sortable_value;
+};
+
 template <typename Range>
-constexpr bool is_sortable_v = std::is_base_of_v<std::bidirectional_iterator_tag, typename std_ext::iterator_t<Range>::iterator_category>;
+struct sortable_value<Range, std::enable_if_t<is_sortable_v<Range>>>
+{
+    using type = std::iter_value_t<std_ext::iterator_t<Range>>;
+};
+
+template <typename Range>
+using sortable_value_t = typename sortable_value<Range>::type;
 
 template <typename Range>
 using enable_if_sortable_t = std::enable_if_t<is_sortable_v<Range>, bool>;
+
+/* The comparator has to be a strict weak order of the projected elements, which also keeps memory resources and scratch spans out */
+template <typename Range, typename Compare, typename Projection, typename = void>
+struct is_sortable_by : std::false_type
+{
+};
+
+template <typename Range, typename Compare, typename Projection>
+struct is_sortable_by<Range, Compare, Projection, std::enable_if_t<is_sortable_v<Range>>>
+    : std::bool_constant<std::indirect_strict_weak_order<Compare, std::projected<std_ext::iterator_t<Range>, Projection>>>
+{
+};
+
+template <typename Range, typename Compare, typename Projection>
+constexpr bool is_sortable_by_v = is_sortable_by<Range, Compare, Projection>::value;
+
+template <typename Range, typename Compare, typename Projection>
+using enable_if_sortable_by_t = std::enable_if_t<is_sortable_by_v<Range, Compare, Projection>, bool>;
+
+template <typename T>
+constexpr bool is_radix_key_v = (std::is_integral_v<T> && !std::is_same_v<T, bool>) ||
+                                (std::is_floating_point_v<T> && std::numeric_limits<T>::is_iec559 && (sizeof(T) == 4 || sizeof(T) == 8));
+
+/* Radix sort reads the bits of the elements, so only integers and IEEE floats qualify */
+template <typename Range>
+constexpr bool is_radix_sortable_v = is_sortable_v<Range> && is_radix_key_v<sortable_value_t<Range>>;
+
+template <typename Range>
+using enable_if_radix_sortable_t = std::enable_if_t<is_radix_sortable_v<Range>, bool>;
+
+/* Bucket sort maps the values linearly onto the buckets, so they have to be numbers */
+template <typename Range>
+constexpr bool is_bucket_sortable_v = is_sortable_v<Range> && std::is_arithmetic_v<sortable_value_t<Range>> &&
+                                      !std::is_same_v<sortable_value_t<Range>, bool>;
+
+template <typename Range>
+using enable_if_bucket_sortable_t = std::enable_if_t<is_bucket_sortable_v<Range>, bool>;
+
+/* Radix argsort reads the bits of the projected keys, so they have to be integers or IEEE floats */
+template <typename Range, typename Projection, typename = void>
+struct is_radix_sortable_by : std::false_type
+{
+};
+
+template <typename Range, typename Projection>
+struct is_radix_sortable_by<
+    Range, Projection,
+    std::enable_if_t<is_radix_key_v<std::remove_cvref_t<std::invoke_result_t<Projection&, std::iter_reference_t<std_ext::iterator_t<Range>>>>>>>
+    : std::bool_constant<is_sortable_v<Range>>
+{
+};
+
+template <typename Range, typename Projection>
+constexpr bool is_radix_sortable_by_v = is_radix_sortable_by<Range, Projection>::value;
+
+template <typename Range, typename Projection>
+using enable_if_radix_sortable_by_t = std::enable_if_t<is_radix_sortable_by_v<Range, Projection>, bool>;
+
+template <typename T>
+constexpr bool is_counting_key_v = (std::is_integral_v<T> && !std::is_same_v<T, bool>) || std::is_enum_v<T>;
+
+/* Counting sort rebuilds the values from their counts, so without a key extractor only integers qualify */
+template <typename Range>
+constexpr bool is_counting_sortable_v = is_sortable_v<Range> && std::is_integral_v<sortable_value_t<Range>> &&
+                                        !std::is_same_v<sortable_value_t<Range>, bool>;
+
+template <typename Range>
+using enable_if_counting_sortable_t = std::enable_if_t<is_counting_sortable_v<Range>, bool>;
+
+template <typename Range, typename KeyExtractor, typename = void>
+struct is_counting_sortable_by : std::false_type
+{
+};
+
+template <typename Range, typename KeyExtractor>
+struct is_counting_sortable_by<
+    Range, KeyExtractor,
+    std::enable_if_t<is_counting_key_v<std::remove_cvref_t<std::invoke_result_t<KeyExtractor&, std::iter_reference_t<std_ext::iterator_t<Range>>>>>>>
+    : std::bool_constant<is_sortable_v<Range>>
+{
+};
+
+template <typename Range, typename KeyExtractor>
+constexpr bool is_counting_sortable_by_v = is_counting_sortable_by<Range, KeyExtractor>::value;
+
+template <typename Range, typename KeyExtractor>
+using enable_if_counting_sortable_by_t = std::enable_if_t<is_counting_sortable_by_v<Range, KeyExtractor>, bool>;
 }  // namespace detail
 }  // namespace algorithm
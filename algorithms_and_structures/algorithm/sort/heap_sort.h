@@ -1,45 +1,204 @@
 #pragma once
 
-#include "include/type_traits.h"
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <tbb/task_arena.h>
+#include "detail/buffer.h"
+#include "detail/compare.h"
+#include "detail/execution.h"
+#include "detail/iterator.h"
+#include "detail/merge.h"
+#include "detail/type_traits.h"
 
 /* Operation iterator +/- n requires random access iterator, we have bidirectorial one so we use std::next, std::prev */
 namespace algorithm
 {
 namespace detail
 {
-void heapify() {}
+/*
+ * The heap is stored implicitly: children of the node i live on positions Arity * i + 1 ... Arity * i + Arity.
+ * Wider heaps are shallower and keep all children of a node next to each other, so for small elements
+ * a 4-ary or 8-ary heap reads one cache line per level.
+ */
+template <std::size_t Arity, typename Iterator, typename T, typename Compare>
+constexpr void heapify(Iterator begin, std::ptrdiff_t size, std::ptrdiff_t top, T value, Compare& comp)
+{
+    constexpr auto arity = static_cast<std::ptrdiff_t>(Arity);
+    auto hole = top;
+
+    /* Leaf search: walk the hole down along the largest children without comparing them to the value */
+    while (true)
+    {
+        const auto first_child = arity * hole + 1;
+        if (first_child >= size)
+        {
+            break;
+        }
+
+        const auto last_child = std::min(first_child + arity, size);
+        auto largest = first_child;
+        auto largest_it = std::next(begin, first_child);
+        auto child_it = largest_it;
+        for (auto child = first_child + 1; child < last_child; ++child)
+        {
+            ++child_it;
+            if (comp(*largest_it, *child_it))
+            {
+                largest = child;
+                largest_it = child_it;
+            }
+        }
+
+        *std::next(begin, hole) = std::ranges::iter_move(largest_it);
+        hole = largest;
+    }
+
+    /* Bounce: the value is usually small, so it only has to climb a level or two back up */
+    while (hole > top)
+    {
+        const auto parent = (hole - 1) / arity;
+        auto parent_it = std::next(begin, parent);
+        if (!comp(*parent_it, value))
+        {
+            break;
+        }
+
+        *std::next(begin, hole) = std::ranges::iter_move(parent_it);
+        hole = parent;
+    }
+
+    *std::next(begin, hole) = std::move(value);
+}
+
+/* Builds a maximal heap bottom-up (Floyd), starting from the last node having children */
+template <std::size_t Arity, typename Iterator, typename Compare>
+constexpr void make_heap(Iterator begin, std::ptrdiff_t size, Compare& comp)
+{
+    constexpr auto arity = static_cast<std::ptrdiff_t>(Arity);
+    for (auto root = (size - 2) / arity; root >= 0; --root)
+    {
+        auto root_it = std::next(begin, root);
+        heapify<Arity>(begin, size, root, std::ranges::iter_move(root_it), comp);
+    }
+}
+
+/* One by one moves the maximum behind the heap and sifts the displaced last element from the root */
+template <std::size_t Arity, typename Iterator, typename Compare>
+constexpr void sort_heap(Iterator begin, std::ptrdiff_t size, Compare& comp)
+{
+    auto last_it = std::next(begin, size - 1);
+    for (auto last = size - 1; last > 0; --last, --last_it)
+    {
+        auto value = std::ranges::iter_move(last_it);
+        *last_it = std::ranges::iter_move(begin);
+        heapify<Arity>(begin, last, 0, std::move(value), comp);
+    }
+}
 
-template <typename Iterator>
-void heap_sort(Iterator begin, Iterator end)
+template <std::size_t Arity = 2, typename Iterator, typename Compare = std::less<>>
+constexpr void heap_sort(Iterator begin, Iterator end, Compare comp = {})
 {
-   auto distance = std::distance(begin, end);
+    static_assert(Arity >= 2, "Heap must have at least two children per node");
 
-   /* Build a maximal heap */
-   for(auto it = std::next(begin, distance/2 - 1) ; std::distance(it, begin) >= 0; --it)
-   {
-      heapify(it, end);
-   }
+    const auto size = std::distance(begin, end);
+    if (size <= 1)
+    {
+        return;
+    }
+
+    if constexpr (!std::random_access_iterator<Iterator>)
+    {
+        /* Every heap step jumps to a distant position, which a list reaches only by walking the nodes, so sort a moved out copy */
+        temporary_buffer<std::iter_value_t<Iterator>> buffer(static_cast<std::size_t>(size), default_resource());
+        if (buffer.size() != 0)
+        {
+            auto buffer_end = move_construct(begin, end, buffer.data());
+            heap_sort<Arity>(buffer.data(), buffer_end, comp);
+            std::move(buffer.data(), buffer_end, begin);
+            std::destroy(buffer.data(), buffer_end);
+            return;
+        }
+    }
 
-   /* One by one extract elements from the heap */
-   for (auto it = std::prev(end); it != begin; --it)
-   {
-      std::swap(*begin, *it);
-      heapify(begin, it);
-   }
+    detail::make_heap<Arity>(begin, size, comp);
+    detail::sort_heap<Arity>(begin, size, comp);
 }
 
+/*
+ * A heap has no parallelism of its own, so the parallel policies cut the range into about one part per thread, heap sort
+ * every part on its own thread and merge the sorted parts by merge path. The other policies run the sequential sort.
+ */
+template <std::size_t Arity, typename ExecutionPolicy, typename Iterator, typename Compare>
+void heap_sort(const ExecutionPolicy&, Iterator begin, Iterator end, Compare comp)
+{
+    if constexpr (is_parallel_policy_v<ExecutionPolicy> && std::random_access_iterator<Iterator>)
+    {
+        const auto size = end - begin;
+        const auto part_size = std::max(size / tbb::this_task_arena::max_concurrency(), parallel_merge_sort_threshold);
+        const auto sort_part = [&comp](auto first, auto last) { heap_sort<Arity>(first, last, comp); };
+        if (parallel_merge_sort(begin, size, default_resource(), comp, part_size, sort_part))
+        {
+            return;
+        }
+    }
+    heap_sort<Arity>(begin, end, comp);
+}
 }  // namespace detail
 
-template <typename Range, typename = detail::enable_if_sortable_t<Range>>
-void heap_sort(Range& range)
+template <std::size_t Arity = 2, typename Range, typename = detail::enable_if_sortable_t<Range>>
+constexpr void heap_sort(Range& range)
+{
+    auto begin = detail::unwrap(std::begin(range));
+    auto end = detail::unwrap(std::end(range));
+
+    if (begin == end)
+    {
+        return;
+    }
+    detail::heap_sort<Arity>(begin, end);
+}
+
+template <std::size_t Arity = 2, typename Range, typename Compare, typename Projection = std::identity,
+          typename = detail::enable_if_sortable_by_t<Range, Compare, Projection>>
+constexpr void heap_sort(Range& range, Compare comp, Projection proj = {})
+{
+    auto begin = detail::unwrap(std::begin(range));
+    auto end = detail::unwrap(std::end(range));
+
+    if (begin == end)
+    {
+        return;
+    }
+    detail::heap_sort<Arity>(begin, end, detail::make_compare(comp, proj));
+}
+
+/* The policies are described in detail/execution.h */
+template <std::size_t Arity = 2, typename ExecutionPolicy, typename Range, typename = detail::enable_if_execution_policy_t<ExecutionPolicy, Range>>
+void heap_sort(ExecutionPolicy&& policy, Range& range)
+{
+    auto begin = detail::unwrap(std::begin(range));
+    auto end = detail::unwrap(std::end(range));
+
+    if (begin == end)
+    {
+        return;
+    }
+    detail::heap_sort<Arity>(policy, begin, end, std::less<>{});
+}
+
+template <std::size_t Arity = 2, typename ExecutionPolicy, typename Range, typename Compare, typename Projection = std::identity,
+          typename = detail::enable_if_execution_policy_by_t<ExecutionPolicy, Range, Compare, Projection>>
+void heap_sort(ExecutionPolicy&& policy, Range& range, Compare comp, Projection proj = {})
 {
-    auto begin = std::begin(range);
-    auto end = std::end(range);
+    auto begin = detail::unwrap(std::begin(range));
+    auto end = detail::unwrap(std::end(range));
 
     if (begin == end)
     {
         return;
     }
-    detail::heap_sort(begin, end);
+    detail::heap_sort<Arity>(policy, begin, end, detail::make_compare(comp, proj));
 }
 }  // namespace algorithm
@@ -1,5 +1,13 @@
 #pragma once
 
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <utility>
+#include "detail/compare.h"
+#include "detail/execution.h"
+#include "detail/iterator.h"
+#include "detail/merge.h"
 #include "detail/type_traits.h"
 
 /* Operation iterator +/- n requires random access iterator, we have bidirectorial one so we use std::next, std::prev */
@@ -7,32 +15,80 @@ namespace algorithm
 {
 namespace detail
 {
-template <typename Iterator>
-void insertion_sort(Iterator begin, Iterator end)
+template <typename Iterator, typename Compare = std::less<>>
+constexpr void insertion_sort(Iterator begin, Iterator end, Compare comp = {})
 {
     for (auto right = std::next(begin); right != end; ++right)
     {
-        const auto to_insert = *right;
+        auto to_insert = std::ranges::iter_move(right);
         auto left = right;
 
         /* Move elements to the right as long as they are greater than to_insert value */
-        while (left != begin && *(std::prev(left)) > to_insert)
+        while (left != begin && comp(to_insert, *std::prev(left)))
         {
-            *left = *(std::prev(left));  // Shift element to the right
-            left = std::prev(left);      // Move left iterator one position left
+            *left = std::ranges::iter_move(std::prev(left));  // Shift element to the right
+            left = std::prev(left);                         // Move left iterator one position left
         }
 
         /* Place right_value in the correct position as being the lowest in the range now */
-        *left = to_insert;
+        *left = std::move(to_insert);
+    }
+}
+
+/* Blocks of this size are insertion sorted on their own threads before the parallel merges */
+constexpr std::ptrdiff_t parallel_insertion_sort_block = 64;
+
+/*
+ * Binary insertion sort: the place of every element is found by binary search and the greater elements are shifted
+ * by one block move, a loop without dependencies between iterations (a memmove for trivial types) instead of the
+ * compare and move loop. Inserting behind the equal elements keeps the sort stable.
+ */
+template <typename Iterator, typename Compare>
+void binary_insertion_sort(Iterator begin, Iterator end, Compare& comp)
+{
+    for (auto right = std::next(begin); right != end; ++right)
+    {
+        if (!comp(*right, *std::prev(right)))
+        {
+            continue;
+        }
+
+        auto to_insert = std::ranges::iter_move(right);
+        auto position = std::upper_bound(begin, right, to_insert, comp);
+        std::move_backward(position, right, std::next(right));
+        *position = std::move(to_insert);
+    }
+}
+
+/*
+ * Under the unsequenced policies the shifts are block moves, under the parallel ones blocks of the range are insertion sorted
+ * on separate threads and merged by merge path. Both keep equal elements in their order.
+ */
+template <typename ExecutionPolicy, typename Iterator, typename Compare>
+void insertion_sort(const ExecutionPolicy&, Iterator begin, Iterator end, Compare comp)
+{
+    if constexpr (!std::random_access_iterator<Iterator> || !(is_parallel_policy_v<ExecutionPolicy> || is_unsequenced_policy_v<ExecutionPolicy>))
+    {
+        insertion_sort(begin, end, comp);
+    }
+    else
+    {
+        const auto sort_block = [&comp](auto first, auto last) { binary_insertion_sort(first, last, comp); };
+        if (is_parallel_policy_v<ExecutionPolicy> &&
+            parallel_merge_sort(begin, end - begin, default_resource(), comp, parallel_insertion_sort_block, sort_block))
+        {
+            return;
+        }
+        binary_insertion_sort(begin, end, comp);
     }
 }
 }  // namespace detail
 
 template <typename Range, typename = detail::enable_if_sortable_t<Range>>
-void insertion_sort(Range& range)
+constexpr void insertion_sort(Range& range)
 {
-    auto begin = std::begin(range);
-    auto end = std::end(range);
+    auto begin = detail::unwrap(std::begin(range));
+    auto end = detail::unwrap(std::end(range));
 
     if (begin == end)
     {
@@ -41,4 +97,49 @@ void insertion_sort(Range& range)
 
     detail::insertion_sort(begin, end);
 }
+
+template <typename Range, typename Compare, typename Projection = std::identity,
+          typename = detail::enable_if_sortable_by_t<Range, Compare, Projection>>
+constexpr void insertion_sort(Range& range, Compare comp, Projection proj = {})
+{
+    auto begin = detail::unwrap(std::begin(range));
+    auto end = detail::unwrap(std::end(range));
+
+    if (begin == end)
+    {
+        return;
+    }
+
+    detail::insertion_sort(begin, end, detail::make_compare(comp, proj));
+}
+
+/* Stable under every policy, the policies are described in detail/execution.h */
+template <typename ExecutionPolicy, typename Range, typename = detail::enable_if_execution_policy_t<ExecutionPolicy, Range>>
+void insertion_sort(ExecutionPolicy&& policy, Range& range)
+{
+    auto begin = detail::unwrap(std::begin(range));
+    auto end = detail::unwrap(std::end(range));
+
+    if (begin == end)
+    {
+        return;
+    }
+
+    detail::insertion_sort(policy, begin, end, std::less<>{});
+}
+
+template <typename ExecutionPolicy, typename Range, typename Compare, typename Projection = std::identity,
+          typename = detail::enable_if_execution_policy_by_t<ExecutionPolicy, Range, Compare, Projection>>
+void insertion_sort(ExecutionPolicy&& policy, Range& range, Compare comp, Projection proj = {})
+{
+    auto begin = detail::unwrap(std::begin(range));
+    auto end = detail::unwrap(std::end(range));
+
+    if (begin == end)
+    {
+        return;
+    }
+
+    detail::insertion_sort(policy, begin, end, detail::make_compare(comp, proj));
+}
 }  // namespace algorithm
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <concepts>
+#include <forward_list>
+#include <functional>
+#include <iterator>
+#include <list>
+#include <type_traits>
+#include "detail/compare.h"
+
+/*
+ * Merge sort for linked lists which relinks the nodes instead of moving the values: elements are never copied or moved.
+ * The relinking merge sort is the one the lists provide themselves; list_sort adds projections, and the comparison sorts
+ * built for arrays hand lists over to it instead of stepping through their nodes as if they were an array.
+ */
+namespace algorithm
+{
+namespace detail
+{
+/* Lists are sorted through their own merge, so forward lists qualify as well */
+template <typename List, typename Compare, typename Projection>
+using enable_if_list_sortable_by_t =
+    std::enable_if_t<std::indirect_strict_weak_order<Compare, std::projected<typename List::iterator, Projection>>, bool>;
+
+/* Sorts taking any range hand lists over to list_sort */
+template <typename Range>
+constexpr bool is_list_v = false;
+
+template <typename T, typename Allocator>
+constexpr bool is_list_v<std::list<T, Allocator>> = true;
+}  // namespace detail
+
+/* Stable, relinks the nodes of the list without copying or moving the elements */
+template <typename T, typename Allocator, typename Compare, typename Projection = std::identity,
+          typename = detail::enable_if_list_sortable_by_t<std::list<T, Allocator>, Compare, Projection>>
+void list_sort(std::list<T, Allocator>& list, Compare comp, Projection proj = {})
+{
+    list.sort(detail::make_compare(comp, proj));
+}
+
+template <typename T, typename Allocator, typename Compare, typename Projection = std::identity,
+          typename = detail::enable_if_list_sortable_by_t<std::forward_list<T, Allocator>, Compare, Projection>>
+void list_sort(std::forward_list<T, Allocator>& list, Compare comp, Projection proj = {})
+{
+    list.sort(detail::make_compare(comp, proj));
+}
+
+template <typename T, typename Allocator>
+void list_sort(std::list<T, Allocator>& list)
+{
+    list_sort(list, std::less<>{});
+}
+
+template <typename T, typename Allocator>
+void list_sort(std::forward_list<T, Allocator>& list)
+{
+    list_sort(list, std::less<>{});
+}
+}  // namespace algorithm
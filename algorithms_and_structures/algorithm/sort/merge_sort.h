@@ -1,91 +1,387 @@
 #pragma once
 
-#include <vector>
-#include "include/type_traits.h"
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <span>
+#include "insertion_sort.h"
+#include "list_sort.h"
+#include "detail/buffer.h"
+#include "detail/compare.h"
+#include "detail/execution.h"
+#include "detail/iterator.h"
+#include "detail/merge.h"
+#include "detail/type_traits.h"
 
 namespace algorithm
 {
 namespace detail
 {
-template <typename Iterator>
-void merge(Iterator begin, Iterator middle, Iterator end)
+/* Ranges up to this size are sorted by insertion sort, which is stable as well and faster on such short ranges */
+constexpr std::ptrdiff_t merge_sort_insertion_threshold = 16;
+
+template <typename Iterator, typename T, typename Compare>
+constexpr void merge(Iterator begin, Iterator middle, Iterator end, std::ptrdiff_t left_size, std::ptrdiff_t right_size, T* buffer,
+                     std::ptrdiff_t buffer_size, Compare& comp)
+{
+    /* Halves are already in order, nothing to merge */
+    if (left_size == 0 || right_size == 0 || !comp(*middle, *std::prev(middle)))
+    {
+        return;
+    }
+
+    if (left_size <= buffer_size)
+    {
+        /* Move the left half out of the way, the merged range is written over it and never overtakes the right half */
+        auto buffer_end = move_construct(begin, middle, buffer);
+        auto left = buffer;
+        auto right = middle;
+        auto current = begin;
+        while (left != buffer_end && right != end)
+        {
+            if (comp(*right, *left))
+            {
+                *current = std::ranges::iter_move(right);
+                ++right;
+            }
+            else
+            {
+                *current = std::ranges::iter_move(left);
+                ++left;
+            }
+            ++current;
+        }
+
+        /* Remaining elements of the right half are already in place */
+        std::move(left, buffer_end, current);
+        std::destroy(buffer, buffer_end);
+        return;
+    }
+
+    if (left_size + right_size == 2)
+    {
+        std::iter_swap(begin, middle);
+        return;
+    }
+
+    /*
+     * The left half does not fit into the buffer. Cut the longer half in the middle, find where its middle element belongs
+     * in the other half and rotate the parts between the cuts, which leaves two independent and smaller merges.
+     */
+    Iterator left_cut;
+    Iterator right_cut;
+    std::ptrdiff_t left_cut_size;
+    std::ptrdiff_t right_cut_size;
+    if (left_size > right_size)
+    {
+        left_cut_size = left_size / 2;
+        left_cut = std::next(begin, left_cut_size);
+        right_cut = std::lower_bound(middle, end, *left_cut, comp);
+        right_cut_size = std::distance(middle, right_cut);
+    }
+    else
+    {
+        right_cut_size = right_size / 2;
+        right_cut = std::next(middle, right_cut_size);
+        left_cut = std::upper_bound(begin, middle, *right_cut, comp);
+        left_cut_size = std::distance(begin, left_cut);
+    }
+
+    auto new_middle = std::rotate(left_cut, middle, right_cut);
+    merge(begin, left_cut, new_middle, left_cut_size, right_cut_size, buffer, buffer_size, comp);
+    merge(new_middle, right_cut, end, left_size - left_cut_size, right_size - right_cut_size, buffer, buffer_size, comp);
+}
+
+template <typename Iterator, typename T, typename Compare>
+constexpr void merge_sort(Iterator begin, Iterator end, std::ptrdiff_t size, T* buffer, std::ptrdiff_t buffer_size, Compare& comp)
+{
+    if (size <= merge_sort_insertion_threshold)
+    {
+        if (size > 1)
+        {
+            insertion_sort(begin, end, comp);
+        }
+        return;
+    }
+
+    /* Select the middle point */
+    const auto left_size = size / 2;
+    auto middle = std::next(begin, left_size);
+
+    /* Sort the left part of the range */
+    merge_sort(begin, middle, left_size, buffer, buffer_size, comp);
+
+    /* Sort the right part of the range */
+    merge_sort(middle, end, size - left_size, buffer, buffer_size, comp);
+
+    /* Merge two halves */
+    merge(begin, middle, end, left_size, size - left_size, buffer, buffer_size, comp);
+}
+
+template <typename Iterator, typename Compare>
+constexpr void sequential_merge_sort(Iterator begin, Iterator end, std::ptrdiff_t size, std::pmr::memory_resource* resource, Compare& comp)
 {
-    using value_type = std::remove_cvref_t<decltype(*begin)>;
+    using value_type = std::iter_value_t<Iterator>;
+
+    /*
+     * Only the left half is ever moved out, so one buffer of half the size serves all the merges.
+     * With less memory the merges that don't fit split themselves by rotations, which costs an extra log n factor.
+     */
+    temporary_buffer<value_type> buffer(static_cast<std::size_t>(size / 2), resource, 1);
+    merge_sort(begin, end, size, buffer.data(), static_cast<std::ptrdiff_t>(buffer.size()), comp);
+}
+
+/* Runs on the calling thread only, threads are used only when a parallel policy asks for them */
+template <typename Iterator, typename Compare = std::less<>>
+constexpr void merge_sort(Iterator begin, Iterator end, std::pmr::memory_resource* resource, Compare comp = {})
+{
+    const auto size = std::distance(begin, end);
+    if (size > 1)
+    {
+        sequential_merge_sort(begin, end, size, resource, comp);
+    }
+}
 
-    /* Copy the left part of the range to the array */
-    std::vector<value_type> left{begin, middle};
+/*
+ * The sequential policies keep the sort on the calling thread. The parallel ones sort the halves as tasks of the arena and
+ * merge them by merge path, which needs a buffer of the whole size instead of a half, and call the comparator from several
+ * threads at once.
+ */
+template <typename ExecutionPolicy, typename Iterator, typename Compare>
+void merge_sort(const ExecutionPolicy&, Iterator begin, Iterator end, Compare comp)
+{
+    const auto size = std::distance(begin, end);
+    if (size <= 1)
+    {
+        return;
+    }
 
-    /* Copy the right part of the range to the array */
-    std::vector<value_type> right{middle, end};
+    if constexpr (is_parallel_policy_v<ExecutionPolicy> && std::random_access_iterator<Iterator>)
+    {
+        const auto sort_leaf = [&comp](auto first, auto last) { insertion_sort(first, last, comp); };
+        if (parallel_merge_sort(begin, size, default_resource(), comp, merge_sort_insertion_threshold, sort_leaf))
+        {
+            return;
+        }
+    }
+    sequential_merge_sort(begin, end, size, default_resource(), comp);
+}
 
-    /* The left_it value is the smallest remaining index of the element in the left array */
-    auto left_it = std::begin(left);
+template <typename Input, typename Output, typename Compare>
+void merge_pass(Input first, std::ptrdiff_t size, std::ptrdiff_t width, Output output, Compare& comp)
+{
+    /* Merge neighbouring runs of the given width from the input to the output */
+    for (std::ptrdiff_t start = 0; start < size; start += 2 * width)
+    {
+        const auto middle_index = std::min(start + width, size);
+        const auto end_index = std::min(start + 2 * width, size);
+        auto middle = std::next(first, middle_index - start);
+        auto last = std::next(middle, end_index - middle_index);
 
-    /* The right_it value is the smallest remaining index of the element in the right array */
-    auto right_it = std::begin(right);
+        output = move_merge(first, middle, middle, last, output, comp);
+        first = last;
+    }
+}
 
-    /* Position from where we start filling the range */
-    auto current = begin;
+template <typename Iterator, typename Compare = std::less<>>
+void bottom_up_merge_sort(Iterator begin, Iterator end, std::pmr::memory_resource* resource, Compare comp = {})
+{
+    using value_type = std::iter_value_t<Iterator>;
 
-    auto left_end = std::end(left);
-    auto right_end = std::end(right);
-    while (left_it != left_end && right_it != right_end)
+    const auto size = std::distance(begin, end);
+    if (size <= merge_sort_insertion_threshold)
     {
-        /* If left half contains smaller element, insert it to the range */
-        if (*left_it < *right_it)
+        if (size > 1)
         {
-            *current = *left_it;
-            ++left_it;
+            insertion_sort(begin, end, comp);
+        }
+        return;
+    }
+
+    /* Runs are merged back and forth between the range and the buffer, so every pass is a single sequential sweep */
+    temporary_buffer<value_type> buffer(static_cast<std::size_t>(size), resource);
+    if (buffer.size() == 0)
+    {
+        /* Not enough memory to hold the whole range, the top-down version gets by with less */
+        merge_sort(begin, end, resource, comp);
+        return;
+    }
+
+    /* Sort short runs in place first */
+    auto run = begin;
+    for (std::ptrdiff_t offset = 0; offset < size; offset += merge_sort_insertion_threshold)
+    {
+        auto run_end = std::next(run, std::min(merge_sort_insertion_threshold, size - offset));
+        insertion_sort(run, run_end, comp);
+        run = run_end;
+    }
+
+    auto buffer_end = std::uninitialized_move(begin, end, buffer.data());
+
+    bool in_buffer = true;
+    for (auto width = merge_sort_insertion_threshold; width < size; width *= 2)
+    {
+        if (in_buffer)
+        {
+            merge_pass(buffer.data(), size, width, begin, comp);
         }
-        /* Otherwise insert right half element to the range */
         else
         {
-            *current = *right_it;
-            ++right_it;
+            merge_pass(begin, size, width, buffer.data(), comp);
         }
-        ++current;
+        in_buffer = !in_buffer;
     }
 
-    /* Some elements could left so copy them to the array */
-    while (left_it != left_end)
+    if (in_buffer)
+    {
+        std::move(buffer.data(), buffer_end, begin);
+    }
+    std::destroy(buffer.data(), buffer_end);
+}
+}  // namespace detail
+
+/* Lists are sorted by relinking their nodes, which needs neither a buffer nor moving the values */
+template <typename Range, typename = detail::enable_if_sortable_t<Range>>
+constexpr void merge_sort(Range& range)
+{
+    if constexpr (detail::is_list_v<Range>)
     {
-        *current = *left_it;
-        ++left_it;
-        ++current;
+        list_sort(range);
     }
-    while (right_it != right_end)
+    else
     {
-        *current = *right_it;
-        ++right_it;
-        ++current;
+        detail::merge_sort(detail::unwrap(std::begin(range)), detail::unwrap(std::end(range)), detail::default_resource());
     }
 }
 
-template <typename Iterator>
-void merge_sort(Iterator begin, Iterator end)
+/* Stable in the order given by comp(proj(a), proj(b)) */
+template <typename Range, typename Compare, typename Projection = std::identity,
+          typename = detail::enable_if_sortable_by_t<Range, Compare, Projection>>
+constexpr void merge_sort(Range& range, Compare comp, Projection proj = {})
 {
-    if (std::distance(begin, end) <= 1)
+    if constexpr (detail::is_list_v<Range>)
     {
-        return;
+        list_sort(range, comp, proj);
     }
+    else
+    {
+        detail::merge_sort(detail::unwrap(std::begin(range)), detail::unwrap(std::end(range)), detail::default_resource(),
+                           detail::make_compare(comp, proj));
+    }
+}
 
-    /* Select the middle point */
-    auto middle = std::next(begin, std::distance(begin, end) / 2);
+/* Stable under every policy, the policies are described in detail/execution.h */
+template <typename ExecutionPolicy, typename Range, typename = detail::enable_if_execution_policy_t<ExecutionPolicy, Range>>
+void merge_sort(ExecutionPolicy&& policy, Range& range)
+{
+    if constexpr (detail::is_list_v<Range>)
+    {
+        list_sort(range);
+    }
+    else
+    {
+        detail::merge_sort(policy, detail::unwrap(std::begin(range)), detail::unwrap(std::end(range)), std::less<>{});
+    }
+}
 
-    /* Sort the left part of the range */
-    merge_sort(begin, middle);
+template <typename ExecutionPolicy, typename Range, typename Compare, typename Projection = std::identity,
+          typename = detail::enable_if_execution_policy_by_t<ExecutionPolicy, Range, Compare, Projection>>
+void merge_sort(ExecutionPolicy&& policy, Range& range, Compare comp, Projection proj = {})
+{
+    if constexpr (detail::is_list_v<Range>)
+    {
+        list_sort(range, comp, proj);
+    }
+    else
+    {
+        detail::merge_sort(policy, detail::unwrap(std::begin(range)), detail::unwrap(std::end(range)), detail::make_compare(comp, proj));
+    }
+}
 
-    /* Sort the right part of the range */
-    merge_sort(middle, end);
+/* Takes the buffer from the given resource, with too little memory the sort gets slower but still works */
+template <typename Range, typename = detail::enable_if_sortable_t<Range>>
+void merge_sort(Range& range, std::pmr::memory_resource* resource)
+{
+    if constexpr (detail::is_list_v<Range>)
+    {
+        list_sort(range);
+    }
+    else
+    {
+        detail::merge_sort(detail::unwrap(std::begin(range)), detail::unwrap(std::end(range)), resource);
+    }
+}
 
-    /* Merge two halves */
-    merge(begin, middle, end);
+/* Never allocates, the buffer is taken from the given memory */
+template <typename Range, typename = detail::enable_if_sortable_t<Range>>
+void merge_sort(Range& range, std::span<std::byte> scratch)
+{
+    if constexpr (detail::is_list_v<Range>)
+    {
+        list_sort(range);
+    }
+    else
+    {
+        detail::scratch_resource resource{scratch};
+        detail::merge_sort(detail::unwrap(std::begin(range)), detail::unwrap(std::end(range)), &resource);
+    }
 }
-}  // namespace detail
 
+/* Merge sort without recursion, runs are merged level by level */
 template <typename Range, typename = detail::enable_if_sortable_t<Range>>
-void merge_sort(Range& range)
+void bottom_up_merge_sort(Range& range)
+{
+    if constexpr (detail::is_list_v<Range>)
+    {
+        list_sort(range);
+    }
+    else
+    {
+        detail::bottom_up_merge_sort(detail::unwrap(std::begin(range)), detail::unwrap(std::end(range)), std::pmr::get_default_resource());
+    }
+}
+
+template <typename Range, typename Compare, typename Projection = std::identity,
+          typename = detail::enable_if_sortable_by_t<Range, Compare, Projection>>
+void bottom_up_merge_sort(Range& range, Compare comp, Projection proj = {})
 {
-    detail::merge_sort(std::begin(range), std::end(range));
+    if constexpr (detail::is_list_v<Range>)
+    {
+        list_sort(range, comp, proj);
+    }
+    else
+    {
+        detail::bottom_up_merge_sort(detail::unwrap(std::begin(range)), detail::unwrap(std::end(range)), std::pmr::get_default_resource(),
+                                     detail::make_compare(comp, proj));
+    }
+}
+
+template <typename Range, typename = detail::enable_if_sortable_t<Range>>
+void bottom_up_merge_sort(Range& range, std::pmr::memory_resource* resource)
+{
+    if constexpr (detail::is_list_v<Range>)
+    {
+        list_sort(range);
+    }
+    else
+    {
+        detail::bottom_up_merge_sort(detail::unwrap(std::begin(range)), detail::unwrap(std::end(range)), resource);
+    }
+}
+
+template <typename Range, typename = detail::enable_if_sortable_t<Range>>
+void bottom_up_merge_sort(Range& range, std::span<std::byte> scratch)
+{
+    if constexpr (detail::is_list_v<Range>)
+    {
+        list_sort(range);
+    }
+    else
+    {
+        detail::scratch_resource resource{scratch};
+        detail::bottom_up_merge_sort(detail::unwrap(std::begin(range)), detail::unwrap(std::end(range)), &resource);
+    }
 }
 }  // namespace algorithm
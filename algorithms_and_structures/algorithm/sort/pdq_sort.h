@@ -0,0 +1,450 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <utility>
+#include "heap_sort.h"
+#include "insertion_sort.h"
+#include "list_sort.h"
+#include "quick_sort.h"
+#include "detail/compare.h"
+#include "detail/iterator.h"
+#include "detail/type_traits.h"
+
+/*
+ * Pattern-defeating quicksort (Orson Peters) with the block partition from BlockQuicksort (Edelkamp & Weiss).
+ * Compared to the classic quick_sort it
+ * - partitions arithmetic types without data dependent branches, comparisons only fill buffers of offsets,
+ * - notices ranges that were already partitioned and finishes them with a bounded insertion sort,
+ * - shuffles a few elements after an unbalanced partition, which breaks patterns that defeat the median of three,
+ * - puts all elements equal to the pivot in place at once, so ranges with many duplicates take linear time.
+ * Works on random access iterators, other ranges are sorted by quick_sort.
+ */
+namespace algorithm
+{
+namespace detail
+{
+/* Partitions shorter than this are finished with insertion sort */
+constexpr std::ptrdiff_t pdq_sort_insertion_threshold = 24;
+
+/* Partitions above this size take the pivot as the ninther instead of the median of three */
+constexpr std::ptrdiff_t pdq_sort_ninther_threshold = 128;
+
+/* Insertion sort of an already partitioned range gives up after moving this many elements */
+constexpr std::ptrdiff_t pdq_sort_partial_insertion_limit = 8;
+
+/* Number of elements classified before swapping, offsets within a block have to fit in one byte */
+constexpr std::size_t pdq_sort_block_size = 64;
+
+/* Offset buffers are aligned to the cache line */
+constexpr std::size_t pdq_sort_cache_line = 64;
+
+template <typename T>
+constexpr bool is_pdq_branchless_v = std::is_arithmetic_v<T>;
+
+/* Insertion sort which relies on an element not greater than any in the range sitting right before it */
+template <typename Iterator, typename Compare>
+void unguarded_insertion_sort(Iterator begin, Iterator end, Compare& comp)
+{
+    for (auto current = std::next(begin); current < end; ++current)
+    {
+        auto sift = current;
+        auto sift_prev = std::prev(current);
+        if (comp(*sift, *sift_prev))
+        {
+            auto to_insert = std::ranges::iter_move(sift);
+            do
+            {
+                *sift = std::ranges::iter_move(sift_prev);
+                --sift;
+            } while (comp(to_insert, *--sift_prev));
+            *sift = std::move(to_insert);
+        }
+    }
+}
+
+/* Attempts an insertion sort and gives up once too many elements had to move, returns true if the range got sorted */
+template <typename Iterator, typename Compare>
+bool partial_insertion_sort(Iterator begin, Iterator end, Compare& comp)
+{
+    if (begin == end)
+    {
+        return true;
+    }
+
+    std::ptrdiff_t moved = 0;
+    for (auto current = std::next(begin); current != end; ++current)
+    {
+        auto sift = current;
+        auto sift_prev = std::prev(current);
+        if (comp(*sift, *sift_prev))
+        {
+            auto to_insert = std::ranges::iter_move(sift);
+            do
+            {
+                *sift = std::ranges::iter_move(sift_prev);
+                --sift;
+            } while (sift != begin && comp(to_insert, *--sift_prev));
+            *sift = std::move(to_insert);
+            moved += current - sift;
+        }
+
+        if (moved > pdq_sort_partial_insertion_limit)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Swaps elements found on the wrong sides, as one cycle of moves unless both sides have the same count */
+template <typename Iterator>
+void swap_offsets(Iterator first, Iterator last, const std::uint8_t* offsets_left, const std::uint8_t* offsets_right, std::size_t count,
+                  bool use_swaps)
+{
+    if (use_swaps)
+    {
+        /* Needed for descending input, where the cycle would move elements twice and break the linear bound */
+        for (std::size_t index = 0; index < count; ++index)
+        {
+            std::iter_swap(first + offsets_left[index], last - offsets_right[index]);
+        }
+    }
+    else if (count > 0)
+    {
+        auto left = first + offsets_left[0];
+        auto right = last - offsets_right[0];
+        auto temporary = std::ranges::iter_move(left);
+        *left = std::ranges::iter_move(right);
+        for (std::size_t index = 1; index < count; ++index)
+        {
+            left = first + offsets_left[index];
+            *right = std::ranges::iter_move(left);
+            right = last - offsets_right[index];
+            *left = std::ranges::iter_move(right);
+        }
+        *right = std::move(temporary);
+    }
+}
+
+/*
+ * Partitions around the pivot taken from the beginning: smaller elements go left, greater or equal go right.
+ * Returns the final pivot position and whether no element had to be moved.
+ */
+template <typename Iterator, typename Compare>
+std::pair<Iterator, bool> partition_right(Iterator begin, Iterator end, Compare& comp)
+{
+    auto pivot = std::ranges::iter_move(begin);
+    auto first = begin;
+    auto last = end;
+
+    /* The median of three guarantees an element not smaller than the pivot to stop this search */
+    while (comp(*++first, pivot))
+    {
+    }
+
+    /* There is no such guard on the right if the pivot was the only smaller element */
+    if (std::prev(first) == begin)
+    {
+        while (first < last && !comp(*--last, pivot))
+        {
+        }
+    }
+    else
+    {
+        while (!comp(*--last, pivot))
+        {
+        }
+    }
+
+    const bool already_partitioned = first >= last;
+
+    if constexpr (is_pdq_branchless_v<std::iter_value_t<Iterator>>)
+    {
+        if (!already_partitioned)
+        {
+            std::iter_swap(first, last);
+            ++first;
+
+            /* Elements on the wrong side are recorded as offsets from the block start, and swapped a block at a time */
+            alignas(pdq_sort_cache_line) std::uint8_t offsets_left[pdq_sort_block_size];
+            alignas(pdq_sort_cache_line) std::uint8_t offsets_right[pdq_sort_block_size];
+
+            auto left_base = first;
+            auto right_base = last;
+            std::size_t left_count = 0;
+            std::size_t right_count = 0;
+            std::size_t left_start = 0;
+            std::size_t right_start = 0;
+
+            while (first < last)
+            {
+                /* Share the unknown elements between the blocks which need refilling */
+                const auto unknown = static_cast<std::size_t>(last - first);
+                const auto left_split = left_count == 0 ? (right_count == 0 ? unknown / 2 : unknown) : 0;
+                const auto right_split = right_count == 0 ? unknown - left_split : 0;
+
+                /* The offset is always written, but the count only grows for elements on the wrong side */
+                for (std::size_t index = 0; index < std::min(left_split, pdq_sort_block_size); ++index)
+                {
+                    offsets_left[left_count] = static_cast<std::uint8_t>(index);
+                    left_count += !comp(*first, pivot);
+                    ++first;
+                }
+                for (std::size_t index = 0; index < std::min(right_split, pdq_sort_block_size); ++index)
+                {
+                    offsets_right[right_count] = static_cast<std::uint8_t>(index + 1);
+                    right_count += comp(*--last, pivot);
+                }
+
+                const auto count = std::min(left_count, right_count);
+                swap_offsets(left_base, right_base, offsets_left + left_start, offsets_right + right_start, count, left_count == right_count);
+                left_count -= count;
+                right_count -= count;
+                left_start += count;
+                right_start += count;
+
+                if (left_count == 0)
+                {
+                    left_start = 0;
+                    left_base = first;
+                }
+                if (right_count == 0)
+                {
+                    right_start = 0;
+                    right_base = last;
+                }
+            }
+
+            /* One of the blocks may still hold misplaced elements, move them next to the boundary */
+            if (left_count > 0)
+            {
+                while (left_count-- > 0)
+                {
+                    std::iter_swap(left_base + offsets_left[left_start + left_count], --last);
+                }
+                first = last;
+            }
+            if (right_count > 0)
+            {
+                while (right_count-- > 0)
+                {
+                    std::iter_swap(right_base - offsets_right[right_start + right_count], first);
+                    ++first;
+                }
+            }
+        }
+    }
+    else
+    {
+        while (first < last)
+        {
+            std::iter_swap(first, last);
+            while (comp(*++first, pivot))
+            {
+            }
+            while (!comp(*--last, pivot))
+            {
+            }
+        }
+    }
+
+    /* Put the pivot between the parts */
+    auto pivot_position = std::prev(first);
+    *begin = std::ranges::iter_move(pivot_position);
+    *pivot_position = std::move(pivot);
+    return {pivot_position, already_partitioned};
+}
+
+/*
+ * Partitions around the pivot taken from the beginning: equal elements go left together with the pivot.
+ * Used when the pivot equals the element before the range, then everything on the left equals the pivot and is done.
+ */
+template <typename Iterator, typename Compare>
+Iterator partition_left(Iterator begin, Iterator end, Compare& comp)
+{
+    auto pivot = std::ranges::iter_move(begin);
+    auto first = begin;
+    auto last = end;
+
+    while (comp(pivot, *--last))
+    {
+    }
+
+    if (std::next(last) == end)
+    {
+        while (first < last && !comp(pivot, *++first))
+        {
+        }
+    }
+    else
+    {
+        while (!comp(pivot, *++first))
+        {
+        }
+    }
+
+    while (first < last)
+    {
+        std::iter_swap(first, last);
+        while (comp(pivot, *--last))
+        {
+        }
+        while (!comp(pivot, *++first))
+        {
+        }
+    }
+
+    *begin = std::ranges::iter_move(last);
+    *last = std::move(pivot);
+    return last;
+}
+
+/* Swaps a few elements of an unbalanced part with ones a quarter further, to break the pattern that caused it */
+template <typename Iterator>
+void break_patterns(Iterator begin, Iterator end)
+{
+    const auto size = end - begin;
+    if (size < pdq_sort_insertion_threshold)
+    {
+        return;
+    }
+
+    const auto quarter = size / 4;
+    std::iter_swap(begin, begin + quarter);
+    std::iter_swap(end - 1, end - quarter);
+    if (size > pdq_sort_ninther_threshold)
+    {
+        std::iter_swap(begin + 1, begin + (quarter + 1));
+        std::iter_swap(begin + 2, begin + (quarter + 2));
+        std::iter_swap(end - 2, end - (quarter + 1));
+        std::iter_swap(end - 3, end - (quarter + 2));
+    }
+}
+
+template <typename Iterator, typename Compare>
+void pdq_sort(Iterator begin, Iterator end, std::ptrdiff_t bad_allowed, bool leftmost, Compare& comp)
+{
+    while (true)
+    {
+        const auto size = end - begin;
+        if (size < pdq_sort_insertion_threshold)
+        {
+            if (leftmost)
+            {
+                if (size > 1)
+                {
+                    insertion_sort(begin, end, comp);
+                }
+            }
+            else
+            {
+                unguarded_insertion_sort(begin, end, comp);
+            }
+            return;
+        }
+
+        /* Median of three (or ninther) goes to the beginning */
+        const auto half = size / 2;
+        if (size > pdq_sort_ninther_threshold)
+        {
+            sort3(begin, begin + half, end - 1, comp);
+            sort3(begin + 1, begin + (half - 1), end - 2, comp);
+            sort3(begin + 2, begin + (half + 1), end - 3, comp);
+            sort3(begin + (half - 1), begin + half, begin + (half + 1), comp);
+            std::iter_swap(begin, begin + half);
+        }
+        else
+        {
+            sort3(begin + half, begin, end - 1, comp);
+        }
+
+        /* The element before the range is not greater than any of it, if it equals the pivot, so do all on the left */
+        if (!leftmost && !comp(*std::prev(begin), *begin))
+        {
+            begin = std::next(partition_left(begin, end, comp));
+            continue;
+        }
+
+        const auto [pivot, already_partitioned] = partition_right(begin, end, comp);
+        const auto left_size = pivot - begin;
+        const auto right_size = end - std::next(pivot);
+
+        if (left_size < size / 8 || right_size < size / 8)
+        {
+            /* Too many bad partitions, switch to the heap sort to keep O(n log n) */
+            if (--bad_allowed == 0)
+            {
+                heap_sort(begin, end, comp);
+                return;
+            }
+
+            break_patterns(begin, pivot);
+            break_patterns(std::next(pivot), end);
+        }
+        else if (already_partitioned && partial_insertion_sort(begin, pivot, comp) && partial_insertion_sort(std::next(pivot), end, comp))
+        {
+            /* Nothing moved during partitioning and both sides got sorted cheaply, the input was probably sorted */
+            return;
+        }
+
+        /* Good partitions shrink both sides to at most 7/8 of the size, so the recursion stays O(log n) deep */
+        pdq_sort(begin, pivot, bad_allowed, leftmost, comp);
+        begin = std::next(pivot);
+        leftmost = false;
+    }
+}
+
+template <typename Iterator, typename Compare = std::less<>>
+void pdq_sort(Iterator begin, Iterator end, Compare comp = {})
+{
+    if constexpr (!std::random_access_iterator<Iterator>)
+    {
+        quick_sort(begin, end, comp);
+    }
+    else
+    {
+        const auto size = end - begin;
+        if (size <= 1)
+        {
+            return;
+        }
+
+        /* Allow log2(n) unbalanced partitions before falling back to the heap sort */
+        const auto bad_allowed = static_cast<std::ptrdiff_t>(std::bit_width(static_cast<std::size_t>(size)));
+        pdq_sort(begin, end, bad_allowed, true, comp);
+    }
+}
+}  // namespace detail
+
+/* Lists are merge sorted by relinking their nodes, like in quick_sort */
+template <typename Range, typename = detail::enable_if_sortable_t<Range>>
+void pdq_sort(Range& range)
+{
+    if constexpr (detail::is_list_v<Range>)
+    {
+        list_sort(range);
+    }
+    else
+    {
+        detail::pdq_sort(detail::unwrap(std::begin(range)), detail::unwrap(std::end(range)));
+    }
+}
+
+template <typename Range, typename Compare, typename Projection = std::identity,
+          typename = detail::enable_if_sortable_by_t<Range, Compare, Projection>>
+void pdq_sort(Range& range, Compare comp, Projection proj = {})
+{
+    if constexpr (detail::is_list_v<Range>)
+    {
+        list_sort(range, comp, proj);
+    }
+    else
+    {
+        detail::pdq_sort(detail::unwrap(std::begin(range)), detail::unwrap(std::end(range)), detail::make_compare(comp, proj));
+    }
+}
+}  // namespace algorithm
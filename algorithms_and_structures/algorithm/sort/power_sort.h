@@ -0,0 +1,345 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include "insertion_sort.h"
+#include "merge_sort.h"
+#include "detail/buffer.h"
+#include "detail/compare.h"
+#include "detail/iterator.h"
+#include "detail/type_traits.h"
+
+/*
+ * Adaptive stable sort for inputs made of sorted pieces (powersort, Munro & Wild).
+ * The range is split into natural runs, short runs are extended by insertion sort, and runs are merged in the order
+ * given by their "power": the depth at which the boundary between two runs would sit in a perfectly balanced merge tree.
+ * Merges switch to galloping (exponential search) when one run keeps winning, so nearly sorted input takes close to O(n).
+ */
+namespace algorithm
+{
+namespace detail
+{
+/* Natural runs shorter than this are extended by insertion sort */
+constexpr std::ptrdiff_t power_sort_minimal_run = 32;
+
+/* A run has to win this many times in a row before the merge starts galloping */
+constexpr std::ptrdiff_t power_sort_minimal_gallop = 7;
+
+/* Powers strictly grow on the run stack and never exceed the number of bits of the size */
+constexpr std::size_t power_sort_max_stack = 64;
+
+template <typename Iterator>
+struct power_sort_run
+{
+    Iterator begin;
+    std::ptrdiff_t offset;
+    std::ptrdiff_t size;
+    std::size_t power;
+};
+
+/*
+ * Power of the boundary between runs [a, b) and [b, c) of a range with n elements: the first bit in which the binary
+ * expansions of the normalized run midpoints (a + b) / 2n and (b + c) / 2n differ.
+ */
+inline std::size_t node_power(std::ptrdiff_t a, std::ptrdiff_t b, std::ptrdiff_t c, std::ptrdiff_t n)
+{
+    const auto two_n = 2 * static_cast<std::size_t>(n);
+    auto left = static_cast<std::size_t>(a + b);
+    auto right = static_cast<std::size_t>(b + c);
+
+    std::size_t power = 0;
+    while (true)
+    {
+        ++power;
+        if (left >= two_n)
+        {
+            left -= two_n;
+            right -= two_n;
+        }
+        else if (right >= two_n)
+        {
+            return power;
+        }
+        left <<= 1;
+        right <<= 1;
+    }
+}
+
+/* Finds the first element not ordered before the value, probing 1, 2, 4... elements ahead before the binary search */
+template <typename Iterator, typename T, typename Compare>
+Iterator gallop_lower_bound(Iterator first, std::ptrdiff_t size, const T& value, Compare& comp)
+{
+    if constexpr (!std::random_access_iterator<Iterator>)
+    {
+        /* Probing ahead would walk the nodes anyway, a linear scan costs no more than the elements it skips */
+        for (; size > 0 && comp(*first, value); --size)
+        {
+            ++first;
+        }
+        return first;
+    }
+
+    std::ptrdiff_t step = 1;
+    std::ptrdiff_t skipped = 0;
+    while (step <= size && comp(*std::next(first, step - 1), value))
+    {
+        skipped = step;
+        step *= 2;
+    }
+
+    auto bracket = std::next(first, skipped);
+    return std::lower_bound(bracket, std::next(bracket, std::min(step, size) - skipped), value, comp);
+}
+
+/* Finds the first element ordered after the value, probing 1, 2, 4... elements ahead before the binary search */
+template <typename Iterator, typename T, typename Compare>
+Iterator gallop_upper_bound(Iterator first, std::ptrdiff_t size, const T& value, Compare& comp)
+{
+    if constexpr (!std::random_access_iterator<Iterator>)
+    {
+        /* Probing ahead would walk the nodes anyway, a linear scan costs no more than the elements it skips */
+        for (; size > 0 && !comp(value, *first); --size)
+        {
+            ++first;
+        }
+        return first;
+    }
+
+    std::ptrdiff_t step = 1;
+    std::ptrdiff_t skipped = 0;
+    while (step <= size && !comp(value, *std::next(first, step - 1)))
+    {
+        skipped = step;
+        step *= 2;
+    }
+
+    auto bracket = std::next(first, skipped);
+    return std::upper_bound(bracket, std::next(bracket, std::min(step, size) - skipped), value, comp);
+}
+
+/*
+ * Merges the left run, moved out to the buffer, with the right run which stays in the range right after the output.
+ * On ties the left run goes first. The same code merges from the back when given reverse iterators and a reversed comparison.
+ */
+template <typename Left, typename Right, typename Compare>
+void gallop_merge(Left left, Left left_end, Right right, Right right_end, Right output, Compare comp, std::ptrdiff_t& min_gallop)
+{
+    auto left_size = std::distance(left, left_end);
+    auto right_size = std::distance(right, right_end);
+
+    while (left_size > 0 && right_size > 0)
+    {
+        /* One element at a time, as long as neither run wins min_gallop times in a row */
+        std::ptrdiff_t left_wins = 0;
+        std::ptrdiff_t right_wins = 0;
+        while (left_size > 0 && right_size > 0 && left_wins < min_gallop && right_wins < min_gallop)
+        {
+            if (comp(*right, *left))
+            {
+                *output = std::ranges::iter_move(right);
+                ++right;
+                --right_size;
+                ++right_wins;
+                left_wins = 0;
+            }
+            else
+            {
+                *output = std::ranges::iter_move(left);
+                ++left;
+                --left_size;
+                ++left_wins;
+                right_wins = 0;
+            }
+            ++output;
+        }
+
+        /* Galloping, whole blocks of one run are found by exponential search and moved at once */
+        while (left_size > 0 && right_size > 0)
+        {
+            auto left_stop = gallop_upper_bound(left, left_size, *right, comp);
+            const auto left_count = std::distance(left, left_stop);
+            output = std::move(left, left_stop, output);
+            left = left_stop;
+            left_size -= left_count;
+            if (left_size == 0)
+            {
+                break;
+            }
+
+            auto right_stop = gallop_lower_bound(right, right_size, *left, comp);
+            const auto right_count = std::distance(right, right_stop);
+            output = std::move(right, right_stop, output);
+            right = right_stop;
+            right_size -= right_count;
+            if (right_size == 0)
+            {
+                break;
+            }
+
+            /* The right run now starts with an element not smaller than the left one */
+            *output = std::ranges::iter_move(left);
+            ++output;
+            ++left;
+            --left_size;
+
+            /* Galloping pays off, so make it easier to enter next time, otherwise go back to one by one */
+            min_gallop = std::max(min_gallop - 1, std::ptrdiff_t{1});
+            if (left_count < power_sort_minimal_gallop && right_count < power_sort_minimal_gallop)
+            {
+                min_gallop += 2;
+                break;
+            }
+        }
+    }
+
+    /* What is left from the right run is already in place */
+    std::move(left, left_end, output);
+}
+
+template <typename Iterator, typename T, typename Compare>
+void merge_runs(Iterator begin, Iterator middle, std::ptrdiff_t left_size, std::ptrdiff_t right_size, T* buffer, std::ptrdiff_t buffer_size,
+                std::ptrdiff_t& min_gallop, Compare& comp)
+{
+    /* Elements of the left run not greater than the first right one are already in place */
+    auto first = gallop_upper_bound(begin, left_size, *middle, comp);
+    left_size -= std::distance(begin, first);
+    if (left_size == 0)
+    {
+        return;
+    }
+
+    /* So are elements of the right run not smaller than the last left one */
+    auto last = gallop_lower_bound(middle, right_size, *std::prev(middle), comp);
+    right_size = std::distance(middle, last);
+
+    if (std::min(left_size, right_size) > buffer_size)
+    {
+        /* Not enough memory for galloping, let the rotation based merge split the runs */
+        merge(first, middle, last, left_size, right_size, buffer, buffer_size, comp);
+        return;
+    }
+
+    /* Only the shorter run is moved out, the longer one is merged in place from its far end */
+    if (left_size <= right_size)
+    {
+        auto buffer_end = std::uninitialized_move(first, middle, buffer);
+        gallop_merge(buffer, buffer_end, middle, last, first, comp, min_gallop);
+        std::destroy(buffer, buffer_end);
+    }
+    else
+    {
+        auto buffer_end = std::uninitialized_move(middle, last, buffer);
+        gallop_merge(std::make_reverse_iterator(buffer_end), std::make_reverse_iterator(buffer), std::make_reverse_iterator(middle),
+                     std::make_reverse_iterator(first), std::make_reverse_iterator(last),
+                     [&comp](const auto& lhs, const auto& rhs) { return comp(rhs, lhs); }, min_gallop);
+        std::destroy(buffer, buffer_end);
+    }
+}
+
+/* Returns the length of the run at the beginning, strictly descending runs are reversed in place */
+template <typename Iterator, typename Compare>
+std::ptrdiff_t find_run(Iterator begin, Iterator end, Compare& comp)
+{
+    auto current = std::next(begin);
+    if (current == end)
+    {
+        return 1;
+    }
+
+    /* Only strictly descending runs are reversed, so equal elements never swap places */
+    std::ptrdiff_t size = 2;
+    if (comp(*current, *begin))
+    {
+        for (++current; current != end && comp(*current, *std::prev(current)); ++current)
+        {
+            ++size;
+        }
+        std::reverse(begin, current);
+    }
+    else
+    {
+        for (++current; current != end && !comp(*current, *std::prev(current)); ++current)
+        {
+            ++size;
+        }
+    }
+    return size;
+}
+
+template <typename Iterator, typename Compare = std::less<>>
+void power_sort(Iterator begin, Iterator end, Compare comp = {})
+{
+    using value_type = std::iter_value_t<Iterator>;
+    using run = power_sort_run<Iterator>;
+
+    const auto size = std::distance(begin, end);
+    if (size <= 1)
+    {
+        return;
+    }
+
+    /* No merge ever moves out more than half of the range */
+    temporary_buffer<value_type> buffer(static_cast<std::size_t>(size / 2), std::pmr::get_default_resource(), 1);
+    const auto buffer_size = static_cast<std::ptrdiff_t>(buffer.size());
+    auto min_gallop = power_sort_minimal_gallop;
+
+    const auto next_run = [&](Iterator first, std::ptrdiff_t offset)
+    {
+        auto run_size = find_run(first, end, comp);
+        if (run_size < power_sort_minimal_run)
+        {
+            run_size = std::min(power_sort_minimal_run, size - offset);
+            insertion_sort(first, std::next(first, run_size), comp);
+        }
+        return run{first, offset, run_size, 0};
+    };
+    const auto merge_with = [&](const run& left, const run& right)
+    {
+        merge_runs(left.begin, right.begin, left.size, right.size, buffer.data(), buffer_size, min_gallop, comp);
+        return run{left.begin, left.offset, left.size + right.size, left.power};
+    };
+
+    std::array<run, power_sort_max_stack> stack;
+    std::size_t stack_size = 0;
+
+    auto current = next_run(begin, 0);
+    while (current.offset + current.size < size)
+    {
+        auto following = next_run(std::next(current.begin, current.size), current.offset + current.size);
+        const auto power = node_power(current.offset, following.offset, following.offset + following.size, size);
+
+        /* Boundaries deeper in the merge tree than the new one are merged first */
+        while (stack_size > 0 && stack[stack_size - 1].power > power)
+        {
+            current = merge_with(stack[--stack_size], current);
+        }
+
+        current.power = power;
+        stack[stack_size++] = current;
+        current = following;
+    }
+
+    while (stack_size > 0)
+    {
+        current = merge_with(stack[--stack_size], current);
+    }
+}
+}  // namespace detail
+
+/* Stable sort which takes advantage of already sorted (or reverse sorted) pieces of the range */
+template <typename Range, typename = detail::enable_if_sortable_t<Range>>
+void power_sort(Range& range)
+{
+    detail::power_sort(detail::unwrap(std::begin(range)), detail::unwrap(std::end(range)));
+}
+
+template <typename Range, typename Compare, typename Projection = std::identity,
+          typename = detail::enable_if_sortable_by_t<Range, Compare, Projection>>
+void power_sort(Range& range, Compare comp, Projection proj = {})
+{
+    detail::power_sort(detail::unwrap(std::begin(range)), detail::unwrap(std::end(range)), detail::make_compare(comp, proj));
+}
+}  // namespace algorithm
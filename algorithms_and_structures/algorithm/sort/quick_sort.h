@@ -1,5 +1,19 @@
 #pragma once
 
+#include <bit>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <tbb/parallel_invoke.h>
+#include "heap_sort.h"
+#include "insertion_sort.h"
+#include "list_sort.h"
+#include "sorting_network.h"
+#include "detail/compare.h"
+#include "detail/execution.h"
+#include "detail/simd_partition.h"
+#include "detail/iterator.h"
 #include "detail/type_traits.h"
 
 /* Operation iterator +/- n requires random access iterator, we have bidirectorial one so we use std::next, std::prev */
@@ -7,53 +21,238 @@ namespace algorithm
 {
 namespace detail
 {
-template <typename Iterator>
-Iterator partition(Iterator begin, Iterator end)
+/* Partitions of at most this size are finished by small_sort: a sorting network for numbers, insertion sort otherwise */
+constexpr std::ptrdiff_t quick_sort_small_threshold = 16;
+
+/* Partitions above this size take the pivot as the ninther instead of the median of three */
+constexpr std::ptrdiff_t quick_sort_ninther_threshold = 128;
+
+template <typename Iterator, typename Compare = std::less<>>
+constexpr void sort3(Iterator a, Iterator b, Iterator c, Compare comp = {})
+{
+    /* Order three elements so that *a <= *b <= *c */
+    if (comp(*b, *a))
+    {
+        std::iter_swap(a, b);
+    }
+    if (comp(*c, *b))
+    {
+        std::iter_swap(b, c);
+        if (comp(*b, *a))
+        {
+            std::iter_swap(a, b);
+        }
+    }
+}
+
+template <typename Iterator, typename Compare>
+constexpr void choose_pivot(Iterator begin, Iterator end, std::ptrdiff_t size, Compare comp)
 {
-    /* Choose the last element as the pivot (can be any random) */
+    auto middle = std::next(begin, size / 2);
+    auto last = std::prev(end);
+
+    sort3(begin, middle, last, comp);
+    if (size > quick_sort_ninther_threshold)
+    {
+        /* Median of three medians (Tukey's ninther) taken from the neighbourhood of the first probes */
+        sort3(std::next(begin), std::prev(middle), std::prev(last), comp);
+        sort3(std::next(begin, 2), std::next(middle), std::prev(last, 2), comp);
+        sort3(std::prev(middle), middle, std::next(middle), comp);
+    }
+
+    /* The partition expects the pivot on the last position */
+    std::iter_swap(middle, last);
+}
+
+template <typename Iterator, typename Compare = std::less<>>
+constexpr Iterator partition(Iterator begin, Iterator end, Compare comp = {})
+{
+    /* The last element is the pivot, choose_pivot places a good candidate there */
     auto pivot = std::prev(end);
 
     /* The left iterator, which will track the boundary between smaller and larger elements */
     auto left = begin;
-    for (auto current = begin; current != std::prev(end); ++current)
+    for (auto current = begin; current != pivot; ++current)
     {
         /* Move through the range and rearrange elements smaller than the pivot to the left */
-        if (*current < *pivot)
+        if (comp(*current, *pivot))
         {
-            std::swap(*left, *current);
+            std::iter_swap(left, current);
             ++left;
         }
     }
 
-    /* The pivot has the smallest value now so move it to the most-left position */
-    std::swap(*left, *pivot);
+    /* Every element before left is smaller than the pivot, so the pivot belongs right there */
+    std::iter_swap(left, pivot);
 
     /* Return the pivot's final position */
     return left;
 }
 
-template <typename Iterator>
-void quick_sort(Iterator begin, Iterator end)
+/* Contiguous numbers in natural order are partitioned by the vectorized kernel when the CPU has one, everything else by the scalar partition */
+template <typename Iterator, typename Compare>
+constexpr Iterator vectorized_partition(Iterator begin, Iterator end, std::ptrdiff_t size, Compare comp)
 {
-    if (begin == end)
+    if constexpr (is_simd_partitionable_v<Iterator> && is_natural_order_v<Compare>)
+    {
+        /* Kernels are not usable in constant evaluation */
+        const auto kernel = std::is_constant_evaluated() ? nullptr : simd_partition_kernel<std::iter_value_t<Iterator>>();
+        if (kernel && size >= simd_partition_minimal_size)
+        {
+            const auto first = std::to_address(begin);
+            return std::next(begin, kernel(first, first + size) - first);
+        }
+    }
+    return detail::partition(begin, end, comp);
+}
+
+template <typename Iterator, typename Compare>
+constexpr void introsort(Iterator begin, Iterator end, std::ptrdiff_t size, std::ptrdiff_t depth_limit, Compare comp)
+{
+    while (size > quick_sort_small_threshold)
+    {
+        /* Too many unbalanced partitions, switch to the heap sort to keep O(n log n) */
+        if (depth_limit == 0)
+        {
+            heap_sort(begin, end, comp);
+            return;
+        }
+        --depth_limit;
+
+        choose_pivot(begin, end, size, comp);
+        auto pivot = vectorized_partition(begin, end, size, comp);
+
+        const auto left_size = std::distance(begin, pivot);
+        const auto right_size = size - left_size - 1;
+
+        /* Recurse into the smaller part and loop over the larger one, so the stack stays O(log n) */
+        if (left_size < right_size)
+        {
+            introsort(begin, pivot, left_size, depth_limit, comp);
+            begin = std::next(pivot);
+            size = right_size;
+        }
+        else
+        {
+            introsort(std::next(pivot), end, right_size, depth_limit, comp);
+            end = pivot;
+            size = left_size;
+        }
+    }
+
+    small_sort(begin, end, size, comp);
+}
+
+template <typename Iterator, typename Compare = std::less<>>
+constexpr void quick_sort(Iterator begin, Iterator end, Compare comp = {})
+{
+    const auto size = std::distance(begin, end);
+    if (size <= 1)
     {
         return;
     }
 
-    /* Partition the range and get the pivot position */
-    auto pivot = partition(begin, end);
+    /* Allow 2 * log2(n) levels of partitioning before falling back to the heap sort */
+    const auto depth_limit = 2 * static_cast<std::ptrdiff_t>(std::bit_width(static_cast<std::size_t>(size)) - 1);
+    introsort(begin, end, size, depth_limit, comp);
+}
 
-    /* Sort elements before the pivot */
-    quick_sort(begin, pivot);
+/* Partitions above this size sort their two parts as separate tasks */
+constexpr std::ptrdiff_t parallel_quick_sort_threshold = std::ptrdiff_t{1} << 13;
 
-    /* Sort elements after the pivot */
-    quick_sort(std::next(pivot), end);
+/* Introsort whose two parts of every large partition are sorted by different threads */
+template <typename Iterator, typename Compare>
+void parallel_introsort(Iterator begin, Iterator end, std::ptrdiff_t size, std::ptrdiff_t depth_limit, Compare& comp)
+{
+    if (size <= parallel_quick_sort_threshold || depth_limit == 0)
+    {
+        introsort(begin, end, size, depth_limit, comp);
+        return;
+    }
+
+    choose_pivot(begin, end, size, comp);
+    auto pivot = vectorized_partition(begin, end, size, comp);
+    const auto left_size = std::distance(begin, pivot);
+    tbb::parallel_invoke([&] { parallel_introsort(begin, pivot, left_size, depth_limit - 1, comp); },
+                         [&] { parallel_introsort(std::next(pivot), end, size - left_size - 1, depth_limit - 1, comp); });
+}
+
+/* Every policy partitions numbers with the vectorized kernels, the parallel ones also sort the parts on separate threads */
+template <typename ExecutionPolicy, typename Iterator, typename Compare>
+void quick_sort(const ExecutionPolicy&, Iterator begin, Iterator end, Compare comp)
+{
+    if constexpr (is_parallel_policy_v<ExecutionPolicy> && std::random_access_iterator<Iterator>)
+    {
+        const auto size = end - begin;
+        if (size <= 1)
+        {
+            return;
+        }
+
+        const auto depth_limit = 2 * static_cast<std::ptrdiff_t>(std::bit_width(static_cast<std::size_t>(size)) - 1);
+        parallel_introsort(begin, end, size, depth_limit, comp);
+    }
+    else
+    {
+        quick_sort(begin, end, comp);
+    }
 }
 }  // namespace detail
 
+/* Lists are merge sorted by relinking their nodes, partitions would step through them one node at a time */
 template <typename Range, typename = detail::enable_if_sortable_t<Range>>
-void quick_sort(Range& range)
+constexpr void quick_sort(Range& range)
+{
+    if constexpr (detail::is_list_v<Range>)
+    {
+        list_sort(range);
+    }
+    else
+    {
+        detail::quick_sort(detail::unwrap(std::begin(range)), detail::unwrap(std::end(range)));
+    }
+}
+
+/* Orders by comp(proj(a), proj(b)) like std::ranges::sort, e.g. std::greater<>{} or a member pointer as the projection */
+template <typename Range, typename Compare, typename Projection = std::identity,
+          typename = detail::enable_if_sortable_by_t<Range, Compare, Projection>>
+constexpr void quick_sort(Range& range, Compare comp, Projection proj = {})
+{
+    if constexpr (detail::is_list_v<Range>)
+    {
+        list_sort(range, comp, proj);
+    }
+    else
+    {
+        detail::quick_sort(detail::unwrap(std::begin(range)), detail::unwrap(std::end(range)), detail::make_compare(comp, proj));
+    }
+}
+
+/* The policies are described in detail/execution.h */
+template <typename ExecutionPolicy, typename Range, typename = detail::enable_if_execution_policy_t<ExecutionPolicy, Range>>
+void quick_sort(ExecutionPolicy&& policy, Range& range)
+{
+    if constexpr (detail::is_list_v<Range>)
+    {
+        list_sort(range);
+    }
+    else
+    {
+        detail::quick_sort(policy, detail::unwrap(std::begin(range)), detail::unwrap(std::end(range)), std::less<>{});
+    }
+}
+
+template <typename ExecutionPolicy, typename Range, typename Compare, typename Projection = std::identity,
+          typename = detail::enable_if_execution_policy_by_t<ExecutionPolicy, Range, Compare, Projection>>
+void quick_sort(ExecutionPolicy&& policy, Range& range, Compare comp, Projection proj = {})
 {
-    detail::quick_sort(std::begin(range), std::end(range));
+    if constexpr (detail::is_list_v<Range>)
+    {
+        list_sort(range, comp, proj);
+    }
+    else
+    {
+        detail::quick_sort(policy, detail::unwrap(std::begin(range)), detail::unwrap(std::end(range)), detail::make_compare(comp, proj));
+    }
 }
 }  // namespace algorithm
@@ -1,11 +1,472 @@
 #pragma once
 
-#include "include/type_traits.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <climits>
+#include <cstdint>
+#include <iterator>
+#include <memory_resource>
+#include <new>
+#include <span>
+#include <utility>
+#include <vector>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_scan.h>
+#include <tbb/task_arena.h>
+#include "quick_sort.h"
+#include "detail/buffer.h"
+#include "detail/execution.h"
+#include "detail/iterator.h"
+#include "detail/type_traits.h"
 
 namespace algorithm
 {
 namespace detail
 {
+/*
+ * Keys are sorted as unsigned integers of the same width. The transformation is monotonic:
+ * - signed integers have their sign bit flipped, so negative values come before positive ones,
+ * - IEEE floats have their sign bit flipped when positive and all bits flipped when negative,
+ *   so that larger magnitudes of negative numbers come first.
+ */
+template <typename T, typename = void>
+struct radix_key
+{
+};
+
+template <typename T>
+struct radix_key<T, std::enable_if_t<std::is_integral_v<T>>>
+{
+    using type = std::make_unsigned_t<T>;
+};
+
+template <typename T>
+struct radix_key<T, std::enable_if_t<std::is_floating_point_v<T>>>
+{
+    using type = std::conditional_t<sizeof(T) == sizeof(std::uint32_t), std::uint32_t, std::uint64_t>;
+};
+
+template <typename T>
+using radix_key_t = typename radix_key<T>::type;
+
+template <typename T>
+constexpr radix_key_t<T> radix_sign_bit = radix_key_t<T>{1} << (sizeof(radix_key_t<T>) * CHAR_BIT - 1);
+
+template <typename T>
+constexpr radix_key_t<T> to_radix_key(T value)
+{
+    using key_type = radix_key_t<T>;
+    if constexpr (std::is_floating_point_v<T>)
+    {
+        const auto bits = std::bit_cast<key_type>(value);
+        return (bits & radix_sign_bit<T>) ? static_cast<key_type>(~bits) : static_cast<key_type>(bits | radix_sign_bit<T>);
+    }
+    else if constexpr (std::is_signed_v<T>)
+    {
+        return static_cast<key_type>(static_cast<key_type>(value) ^ radix_sign_bit<T>);
+    }
+    else
+    {
+        return value;
+    }
+}
+
+template <typename T>
+constexpr T from_radix_key(radix_key_t<T> key)
+{
+    using key_type = radix_key_t<T>;
+    if constexpr (std::is_floating_point_v<T>)
+    {
+        const auto bits = (key & radix_sign_bit<T>) ? static_cast<key_type>(key ^ radix_sign_bit<T>) : static_cast<key_type>(~key);
+        return std::bit_cast<T>(bits);
+    }
+    else if constexpr (std::is_signed_v<T>)
+    {
+        return static_cast<T>(static_cast<key_type>(key ^ radix_sign_bit<T>));
+    }
+    else
+    {
+        return key;
+    }
+}
+
+template <typename Key, std::size_t DigitBits>
+struct radix_digits
+{
+    static_assert(DigitBits == 8 || DigitBits == 11 || DigitBits == 16, "Supported digit widths are 8, 11 and 16 bits");
+
+    static constexpr std::size_t buckets = std::size_t{1} << DigitBits;
+    static constexpr std::size_t passes = (sizeof(Key) * CHAR_BIT + DigitBits - 1) / DigitBits;
+
+    static constexpr std::size_t digit(Key key, std::size_t pass)
+    {
+        return static_cast<std::size_t>(key >> (pass * DigitBits)) & (buckets - 1);
+    }
+};
+
+template <std::size_t DigitBits, bool SkipUniformDigits, typename Key>
+void radix_sort_keys(std::pmr::vector<Key>& keys, std::pmr::vector<Key>& buffer, std::pmr::vector<std::size_t>& histograms)
+{
+    using digits = radix_digits<Key, DigitBits>;
+    const auto size = keys.size();
+
+    for (std::size_t pass = 0; pass < digits::passes; ++pass)
+    {
+        auto count = std::next(histograms.begin(), static_cast<std::ptrdiff_t>(pass * digits::buckets));
+
+        /* All keys fall into one bucket, the pass would only copy them */
+        if (SkipUniformDigits && count[digits::digit(keys.front(), pass)] == size)
+        {
+            continue;
+        }
+
+        /* Turn counts into starting offsets of the buckets */
+        std::size_t offset = 0;
+        for (std::size_t bucket = 0; bucket < digits::buckets; ++bucket)
+        {
+            offset += std::exchange(count[bucket], offset);
+        }
+
+        /* Stable scatter, so the order established by previous passes is kept */
+        for (const auto key : keys)
+        {
+            buffer[count[digits::digit(key, pass)]++] = key;
+        }
+        keys.swap(buffer);
+    }
+}
+
+template <std::size_t DigitBits = 8, bool SkipUniformDigits = true, typename Iterator>
+void radix_sort(Iterator begin, Iterator end, std::pmr::memory_resource* resource)
+{
+    using value_type = std::iter_value_t<Iterator>;
+    using key_type = radix_key_t<value_type>;
+    using digits = radix_digits<key_type, DigitBits>;
+
+    const auto size = static_cast<std::size_t>(std::distance(begin, end));
+    if (size <= 1)
+    {
+        return;
+    }
+
+    std::pmr::vector<key_type> keys{resource};
+    std::pmr::vector<key_type> buffer{resource};
+    std::pmr::vector<std::size_t> histograms{resource};
+    try
+    {
+        keys.reserve(size);
+        buffer.resize(size);
+        histograms.resize(digits::passes * digits::buckets);
+    }
+    catch (const std::bad_alloc&)
+    {
+        /* No room for the keys, sort in place instead */
+        quick_sort(begin, end);
+        return;
+    }
+
+    /* Histograms of all the digits are gathered in one read of the range */
+    for (auto it = begin; it != end; ++it)
+    {
+        const auto key = to_radix_key(*it);
+        keys.push_back(key);
+        for (std::size_t pass = 0; pass < digits::passes; ++pass)
+        {
+            ++histograms[pass * digits::buckets + digits::digit(key, pass)];
+        }
+    }
+
+    radix_sort_keys<DigitBits, SkipUniformDigits>(keys, buffer, histograms);
+
+    for (const auto key : keys)
+    {
+        *begin = from_radix_key<value_type>(key);
+        ++begin;
+    }
+}
+
+/* Size of the software write-combining line kept for every bucket */
+constexpr std::size_t radix_cache_line = 64;
+
+/* Software write-combining lines of one scatter task, one cache line per bucket, reused by every pass */
+template <typename Key, std::size_t DigitBits, bool = (DigitBits <= 11)>
+struct radix_scatter_lines
+{
+    static constexpr std::size_t capacity = radix_cache_line / sizeof(Key);
+
+    alignas(radix_cache_line) std::array<Key, radix_digits<Key, DigitBits>::buckets * capacity> keys;
+
+    /* Slot the current line of the bucket starts on, only the first line of a bucket may start inside a cache line */
+    std::array<std::size_t, radix_digits<Key, DigitBits>::buckets> first;
+};
+
+/* Wider digits are scattered directly and need no lines */
+template <typename Key, std::size_t DigitBits>
+struct radix_scatter_lines<Key, DigitBits, false>
+{
+};
 
+template <std::size_t DigitBits, typename Key>
+void radix_scatter(const Key* first, const Key* last, Key* output, std::size_t* offsets, std::size_t pass,
+                   [[maybe_unused]] radix_scatter_lines<Key, DigitBits>& lines)
+{
+    using digits = radix_digits<Key, DigitBits>;
+
+    /* With 16-bit digits the lines would not fit in the cache any more, so keys are scattered directly */
+    if constexpr (DigitBits > 11)
+    {
+        for (; first != last; ++first)
+        {
+            output[offsets[digits::digit(*first, pass)]++] = *first;
+        }
+    }
+    else
+    {
+        /*
+         * Keys are first collected in a cache line sized buffer per bucket and written out a full line at a time,
+         * so the scatter touches one output line per flush instead of one per key. A key takes the slot its output
+         * position has in its cache line, so every full flush covers exactly one aligned line of the output.
+         */
+        constexpr std::size_t capacity = radix_scatter_lines<Key, DigitBits>::capacity;
+        const auto skew = (reinterpret_cast<std::uintptr_t>(output) / sizeof(Key)) % capacity;
+        for (std::size_t bucket = 0; bucket < digits::buckets; ++bucket)
+        {
+            lines.first[bucket] = (offsets[bucket] + skew) % capacity;
+        }
+
+        for (; first != last; ++first)
+        {
+            const auto bucket = digits::digit(*first, pass);
+            const auto slot = (offsets[bucket] + skew) % capacity;
+            auto line = lines.keys.data() + bucket * capacity;
+            line[slot] = *first;
+            ++offsets[bucket];
+            if (slot == capacity - 1)
+            {
+                const auto from = std::exchange(lines.first[bucket], 0);
+                std::copy(line + from, line + capacity, output + offsets[bucket] - (capacity - from));
+            }
+        }
+
+        /* Partly filled lines are written out as they are */
+        for (std::size_t bucket = 0; bucket < digits::buckets; ++bucket)
+        {
+            const auto from = lines.first[bucket];
+            const auto to = (offsets[bucket] + skew) % capacity;
+            if (to > from)
+            {
+                const auto line = lines.keys.data() + bucket * capacity;
+                std::copy(line + from, line + to, output + offsets[bucket] - (to - from));
+            }
+        }
+    }
+}
+
+template <std::size_t DigitBits, bool SkipUniformDigits, typename Key>
+void parallel_radix_sort_keys(std::vector<Key>& keys, std::vector<Key>& buffer)
+{
+    using digits = radix_digits<Key, DigitBits>;
+    const auto size = keys.size();
+
+    /* Every chunk of the input is owned by one task, which counts and scatters only its own keys */
+    const auto chunks = static_cast<std::size_t>(tbb::this_task_arena::max_concurrency());
+    const auto chunk_size = (size + chunks - 1) / chunks;
+    const auto chunk_range = tbb::blocked_range<std::size_t>{0, chunks, 1};
+
+    /* Histogram of the chunk c is stored on positions c * buckets ... (c + 1) * buckets - 1 */
+    std::vector<std::size_t> histograms(chunks * digits::buckets);
+    std::vector<std::size_t> totals(digits::buckets);
+
+    /* Write-combining lines of every chunk are allocated once for all the passes */
+    std::vector<radix_scatter_lines<Key, DigitBits>> lines(chunks);
+
+    for (std::size_t pass = 0; pass < digits::passes; ++pass)
+    {
+        tbb::parallel_for(
+            chunk_range,
+            [&](const auto& range)
+            {
+                for (auto chunk = range.begin(); chunk != range.end(); ++chunk)
+                {
+                    auto histogram = histograms.data() + chunk * digits::buckets;
+                    std::fill_n(histogram, digits::buckets, 0);
+                    const auto first = std::min(chunk * chunk_size, size);
+                    const auto last = std::min(first + chunk_size, size);
+                    for (auto index = first; index < last; ++index)
+                    {
+                        ++histogram[digits::digit(keys[index], pass)];
+                    }
+                }
+            },
+            tbb::static_partitioner{});
+
+        /* Merge the local histograms bucket by bucket */
+        tbb::parallel_for(tbb::blocked_range<std::size_t>{0, digits::buckets},
+                          [&](const auto& range)
+                          {
+                              for (auto bucket = range.begin(); bucket != range.end(); ++bucket)
+                              {
+                                  std::size_t total = 0;
+                                  for (std::size_t chunk = 0; chunk < chunks; ++chunk)
+                                  {
+                                      total += histograms[chunk * digits::buckets + bucket];
+                                  }
+                                  totals[bucket] = total;
+                              }
+                          });
+
+        /* All keys fall into one bucket, the pass would only copy them */
+        if (SkipUniformDigits && totals[digits::digit(keys.front(), pass)] == size)
+        {
+            continue;
+        }
+
+        /* Exclusive prefix sum of the bucket sizes gives the start of every bucket in the output */
+        tbb::parallel_scan(
+            tbb::blocked_range<std::size_t>{0, digits::buckets}, std::size_t{0},
+            [&](const auto& range, std::size_t sum, bool is_final_scan)
+            {
+                for (auto bucket = range.begin(); bucket != range.end(); ++bucket)
+                {
+                    const auto count = totals[bucket];
+                    if (is_final_scan)
+                    {
+                        totals[bucket] = sum;
+                    }
+                    sum += count;
+                }
+                return sum;
+            },
+            [](std::size_t lhs, std::size_t rhs) { return lhs + rhs; });
+
+        /* Inside a bucket chunks follow each other in input order, which keeps the sort stable */
+        tbb::parallel_for(tbb::blocked_range<std::size_t>{0, digits::buckets},
+                          [&](const auto& range)
+                          {
+                              for (auto bucket = range.begin(); bucket != range.end(); ++bucket)
+                              {
+                                  auto offset = totals[bucket];
+                                  for (std::size_t chunk = 0; chunk < chunks; ++chunk)
+                                  {
+                                      offset += std::exchange(histograms[chunk * digits::buckets + bucket], offset);
+                                  }
+                              }
+                          });
+
+        /* Chunks write to disjoint parts of the shared buffer, so no synchronization is needed */
+        tbb::parallel_for(
+            chunk_range,
+            [&](const auto& range)
+            {
+                for (auto chunk = range.begin(); chunk != range.end(); ++chunk)
+                {
+                    const auto first = std::min(chunk * chunk_size, size);
+                    const auto last = std::min(first + chunk_size, size);
+                    radix_scatter<DigitBits>(keys.data() + first, keys.data() + last, buffer.data(),
+                                             histograms.data() + chunk * digits::buckets, pass, lines[chunk]);
+                }
+            },
+            tbb::static_partitioner{});
+
+        keys.swap(buffer);
+    }
+}
+
+template <std::size_t DigitBits = 8, bool SkipUniformDigits = true, typename Iterator>
+void parallel_radix_sort(Iterator begin, Iterator end)
+{
+    using value_type = std::iter_value_t<Iterator>;
+    using key_type = radix_key_t<value_type>;
+
+    /* Chunks are addressed by position, which is only cheap for random access iterators */
+    const auto size = static_cast<std::size_t>(std::distance(begin, end));
+    if constexpr (!std::random_access_iterator<Iterator>)
+    {
+        radix_sort<DigitBits, SkipUniformDigits>(begin, end, std::pmr::get_default_resource());
+    }
+    else if (size < parallel_distribution_sort_threshold)
+    {
+        radix_sort<DigitBits, SkipUniformDigits>(begin, end, std::pmr::get_default_resource());
+    }
+    else
+    {
+        std::vector<key_type> keys(size);
+        std::vector<key_type> buffer(size);
+
+        const auto blocks = tbb::blocked_range<std::size_t>{0, size};
+        tbb::parallel_for(blocks,
+                          [&](const auto& range)
+                          {
+                              for (auto index = range.begin(); index != range.end(); ++index)
+                              {
+                                  keys[index] = to_radix_key(begin[static_cast<std::ptrdiff_t>(index)]);
+                              }
+                          });
+
+        parallel_radix_sort_keys<DigitBits, SkipUniformDigits>(keys, buffer);
+
+        tbb::parallel_for(blocks,
+                          [&](const auto& range)
+                          {
+                              for (auto index = range.begin(); index != range.end(); ++index)
+                              {
+                                  begin[static_cast<std::ptrdiff_t>(index)] = from_radix_key<value_type>(keys[index]);
+                              }
+                          });
+    }
+}
+
+/* Scatter passes depend on the previous element of the same digit, so only the parallel policies change the algorithm */
+template <std::size_t DigitBits, bool SkipUniformDigits, typename ExecutionPolicy, typename Iterator>
+void radix_sort(const ExecutionPolicy&, Iterator begin, Iterator end)
+{
+    if constexpr (is_parallel_policy_v<ExecutionPolicy>)
+    {
+        parallel_radix_sort<DigitBits, SkipUniformDigits>(begin, end);
+    }
+    else
+    {
+        radix_sort<DigitBits, SkipUniformDigits>(begin, end, std::pmr::get_default_resource());
+    }
+}
 }  // namespace detail
+
+template <std::size_t DigitBits = 8, bool SkipUniformDigits = true, typename Range, typename = detail::enable_if_radix_sortable_t<Range>>
+void radix_sort(Range& range)
+{
+    detail::radix_sort<DigitBits, SkipUniformDigits>(detail::unwrap(std::begin(range)), detail::unwrap(std::end(range)),
+                                                     std::pmr::get_default_resource());
+}
+
+/* Takes the key buffers from the given resource, without enough memory the range is sorted in place by quick_sort */
+template <std::size_t DigitBits = 8, bool SkipUniformDigits = true, typename Range, typename = detail::enable_if_radix_sortable_t<Range>>
+void radix_sort(Range& range, std::pmr::memory_resource* resource)
+{
+    detail::radix_sort<DigitBits, SkipUniformDigits>(detail::unwrap(std::begin(range)), detail::unwrap(std::end(range)), resource);
+}
+
+/* Never allocates, the key buffers are taken from the given memory */
+template <std::size_t DigitBits = 8, bool SkipUniformDigits = true, typename Range, typename = detail::enable_if_radix_sortable_t<Range>>
+void radix_sort(Range& range, std::span<std::byte> scratch)
+{
+    detail::scratch_resource resource{scratch};
+    detail::radix_sort<DigitBits, SkipUniformDigits>(detail::unwrap(std::begin(range)), detail::unwrap(std::end(range)), &resource);
+}
+
+/* Multithreaded version of the radix_sort, meant for large ranges */
+template <std::size_t DigitBits = 8, bool SkipUniformDigits = true, typename Range, typename = detail::enable_if_radix_sortable_t<Range>>
+void parallel_radix_sort(Range& range)
+{
+    detail::parallel_radix_sort<DigitBits, SkipUniformDigits>(detail::unwrap(std::begin(range)), detail::unwrap(std::end(range)));
+}
+
+/* The parallel policies run parallel_radix_sort, the others radix_sort */
+template <std::size_t DigitBits = 8, bool SkipUniformDigits = true, typename ExecutionPolicy, typename Range,
+          typename = detail::enable_if_execution_policy_t<ExecutionPolicy, Range>, typename = detail::enable_if_radix_sortable_t<Range>>
+void radix_sort(ExecutionPolicy&& policy, Range& range)
+{
+    detail::radix_sort<DigitBits, SkipUniformDigits>(policy, detail::unwrap(std::begin(range)), detail::unwrap(std::end(range)));
+}
 }  // namespace algorithm
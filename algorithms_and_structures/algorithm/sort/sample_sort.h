@@ -0,0 +1,593 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <mutex>
+#include <random>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+#include "list_sort.h"
+#include "pdq_sort.h"
+#include "detail/compare.h"
+#include "detail/iterator.h"
+#include "detail/type_traits.h"
+
+/*
+ * Parallel in-place samplesort after IPS4o (Axtmann, Witt, Ferizovic & Sanders). One level of the recursion
+ * - picks splitters from a random sample and stores them as a complete search tree, so an element finds its bucket by
+ *   log2(buckets) comparisons without branches; duplicate splitters switch on equality buckets, which need no recursion,
+ * - lets every thread classify its stripe of the range into small per-bucket buffers, a full buffer is written back as a
+ *   block over the already read part of the stripe,
+ * - moves the blocks into the regions of their buckets, the moves form chains and cycles which run in parallel,
+ * - fills the gaps at the bucket edges with the partially filled buffers and the blocks crossing a bucket boundary,
+ * - sorts the buckets recursively as TBB tasks, work stealing balances them; small buckets are sorted by pdq_sort.
+ * Besides the range it needs a few blocks per thread and bucket, independent of the size of the range. The buffers are
+ * allocated by the first level and handed down the recursion, the levels below reuse them.
+ */
+namespace algorithm
+{
+namespace detail
+{
+/* Elements of a block fill about this many bytes */
+constexpr std::size_t sample_sort_block_bytes = 2048;
+
+/* Buckets of one level, doubled when equality buckets are used */
+constexpr std::size_t sample_sort_max_buckets = 256;
+
+/* Every thread gets at least this many elements, smaller ranges are sorted sequentially */
+constexpr std::ptrdiff_t sample_sort_stripe_size = std::ptrdiff_t{1} << 14;
+
+/* Elements classified together, their searches in the tree are independent and overlap in the pipeline */
+constexpr std::size_t sample_sort_batch = 8;
+
+/* Block moves of one task, longer chains and cycles of moves are split between tasks */
+constexpr std::size_t sample_sort_min_moves = 16;
+
+template <typename T>
+constexpr std::ptrdiff_t sample_sort_block_size_v = std::max<std::ptrdiff_t>(1, sample_sort_block_bytes / sizeof(T));
+
+/* Sorted splitters laid out as a complete binary search tree in breadth first order (Eytzinger layout) */
+template <typename T, typename Compare>
+class splitter_tree
+{
+    public:
+    /* Takes sorted splitters, their count plus one has to be a power of two */
+    splitter_tree(std::vector<T> splitters, bool equality_buckets, Compare& comp)
+        : sorted_(std::move(splitters)), levels_(static_cast<std::size_t>(std::bit_width(sorted_.size()))), equality_buckets_(equality_buckets),
+          comp_(&comp)
+    {
+        const auto leaves = sorted_.size() + 1;
+        tree_.reserve(leaves);
+        tree_.push_back(sorted_.front());
+        for (std::size_t node = 1; node < leaves; ++node)
+        {
+            /* Nodes of one level split the sorted splitters evenly */
+            const auto level = static_cast<std::size_t>(std::bit_width(node)) - 1;
+            const auto offset = node - (std::size_t{1} << level);
+            tree_.push_back(sorted_[(2 * offset + 1) * (leaves >> (level + 1)) - 1]);
+        }
+    }
+
+    std::size_t buckets() const
+    {
+        return equality_buckets_ ? 2 * tree_.size() : tree_.size();
+    }
+
+    /* Buckets of equal elements are already sorted */
+    bool is_equality_bucket(std::size_t bucket) const
+    {
+        return equality_buckets_ && bucket % 2 == 1;
+    }
+
+    /* The bucket is the number of splitters smaller than the element, equality buckets take elements equal to the next splitter */
+    template <typename Iterator>
+    void classify(Iterator first, std::size_t count, std::uint16_t* buckets) const
+    {
+        auto& comp = *comp_;
+        std::size_t nodes[sample_sort_batch];
+        std::fill_n(nodes, count, std::size_t{1});
+        for (std::size_t level = 0; level < levels_; ++level)
+        {
+            for (std::size_t index = 0; index < count; ++index)
+            {
+                nodes[index] = 2 * nodes[index] + static_cast<std::size_t>(comp(tree_[nodes[index]], first[static_cast<std::ptrdiff_t>(index)]));
+            }
+        }
+
+        for (std::size_t index = 0; index < count; ++index)
+        {
+            auto bucket = nodes[index] - tree_.size();
+            if (equality_buckets_)
+            {
+                const bool equal = bucket < sorted_.size() && !comp(first[static_cast<std::ptrdiff_t>(index)], sorted_[bucket]);
+                bucket = 2 * bucket + static_cast<std::size_t>(equal);
+            }
+            buckets[index] = static_cast<std::uint16_t>(bucket);
+        }
+    }
+
+    private:
+    std::vector<T> sorted_;
+    std::vector<T> tree_;
+    std::size_t levels_;
+    bool equality_buckets_;
+    Compare* comp_;
+};
+
+/* Moves a random sample to the beginning of the range, sorts it and picks equidistant splitters from it */
+template <typename Iterator, typename Compare>
+splitter_tree<std::iter_value_t<Iterator>, Compare> choose_splitters(Iterator begin, std::ptrdiff_t size, std::size_t buckets, Compare& comp)
+{
+    /* Larger ranges take a larger sample per bucket, so the buckets come out more even */
+    const auto oversampling = std::max<std::size_t>(1, static_cast<std::size_t>(std::bit_width(static_cast<std::size_t>(size))) / 5);
+    const auto sample = static_cast<std::ptrdiff_t>(std::min(buckets * oversampling, static_cast<std::size_t>(size / 2)));
+
+    /* A 64-bit engine, so the sample is drawn from the whole of ranges longer than 2^31 elements */
+    std::mt19937_64 generator{static_cast<std::mt19937_64::result_type>(size)};
+    for (std::ptrdiff_t index = 0; index < sample; ++index)
+    {
+        std::uniform_int_distribution<std::ptrdiff_t> position{index, size - 1};
+        std::iter_swap(begin + index, begin + position(generator));
+    }
+    pdq_sort(begin, begin + sample, comp);
+
+    std::vector<std::iter_value_t<Iterator>> splitters;
+    splitters.reserve(buckets - 1);
+    for (std::size_t bucket = 1; bucket < buckets; ++bucket)
+    {
+        const auto& candidate = begin[static_cast<std::ptrdiff_t>(bucket) * sample / static_cast<std::ptrdiff_t>(buckets)];
+        if (splitters.empty() || comp(splitters.back(), candidate))
+        {
+            splitters.push_back(candidate);
+        }
+    }
+
+    /*
+     * Duplicate splitters mean many equal elements, which get buckets of their own. So does a single splitter,
+     * otherwise all elements could fall into one bucket again. Missing splitters repeat the last one.
+     */
+    const bool equality_buckets = splitters.size() + 1 < buckets || splitters.size() == 1;
+    splitters.resize(std::bit_ceil(splitters.size() + 1) - 1, splitters.back());
+    return {std::move(splitters), equality_buckets, comp};
+}
+
+/* Part of the range classified by one thread, with its partially filled block of every bucket */
+template <typename T>
+struct sample_sort_stripe
+{
+    std::ptrdiff_t begin = 0;
+    std::ptrdiff_t end = 0;
+    std::ptrdiff_t written = 0;
+    std::vector<std::vector<T>> buffers;
+};
+
+/*
+ * Bucket buffers of the stripes, shared by all levels of one sort. A level takes a set per stripe and gives it back, empty
+ * but with its capacity kept, before its buckets are sorted; levels running at the same time take sets of their own.
+ */
+template <typename T>
+class sample_sort_buffers
+{
+    public:
+    std::vector<std::vector<T>> acquire()
+    {
+        std::lock_guard lock{mutex_};
+        if (free_.empty())
+        {
+            return {};
+        }
+        auto buffers = std::move(free_.back());
+        free_.pop_back();
+        return buffers;
+    }
+
+    void release(std::vector<std::vector<T>> buffers)
+    {
+        std::lock_guard lock{mutex_};
+        free_.push_back(std::move(buffers));
+    }
+
+    private:
+    std::mutex mutex_;
+    std::vector<std::vector<std::vector<T>>> free_;
+};
+
+/*
+ * Reads the stripe into the buffers of the buckets and writes every full buffer back as a block at the beginning of the
+ * stripe. A buffer is full only after a block more has been read than written, so no unread element is overwritten.
+ */
+template <typename Iterator, typename Tree>
+void classify_stripe(Iterator begin, const Tree& tree, std::ptrdiff_t block_size, sample_sort_stripe<std::iter_value_t<Iterator>>& stripe,
+                     std::uint16_t* block_buckets)
+{
+    /* Buffers of a reused set are empty, a set taken from a level with more buckets keeps its extra buffers */
+    if (stripe.buffers.size() < tree.buckets())
+    {
+        stripe.buffers.resize(tree.buckets());
+    }
+    for (std::size_t bucket = 0; bucket < tree.buckets(); ++bucket)
+    {
+        stripe.buffers[bucket].reserve(static_cast<std::size_t>(block_size));
+    }
+
+    std::uint16_t buckets[sample_sort_batch];
+    stripe.written = stripe.begin;
+    for (auto read = stripe.begin; read < stripe.end;)
+    {
+        const auto count = std::min(static_cast<std::ptrdiff_t>(sample_sort_batch), stripe.end - read);
+        tree.classify(begin + read, static_cast<std::size_t>(count), buckets);
+        for (std::ptrdiff_t index = 0; index < count; ++index)
+        {
+            auto& buffer = stripe.buffers[buckets[index]];
+            buffer.push_back(std::ranges::iter_move(begin + (read + index)));
+            if (static_cast<std::ptrdiff_t>(buffer.size()) == block_size)
+            {
+                std::move(buffer.begin(), buffer.end(), begin + stripe.written);
+                block_buckets[stripe.written / block_size] = buckets[index];
+                stripe.written += block_size;
+                buffer.clear();
+            }
+        }
+        read += count;
+    }
+}
+
+/*
+ * Blocks at positions [begin, end) of a chain or a cycle of moves, the content of every block moves to the next one.
+ * The last block goes to the block at position next, a chain ends with an empty block instead.
+ */
+struct block_moves
+{
+    std::size_t begin;
+    std::size_t end;
+    std::size_t next;
+};
+
+template <typename Iterator, typename Compare>
+void parallel_sample_sort(Iterator begin, Iterator end, Compare& comp, sample_sort_buffers<std::iter_value_t<Iterator>>& pool);
+
+/* One level of the samplesort: distributes the range into buckets in place and sorts the buckets in parallel */
+template <typename Iterator, typename Compare>
+void sample_sort_level(Iterator begin, std::ptrdiff_t size, std::size_t stripes, Compare& comp,
+                       sample_sort_buffers<std::iter_value_t<Iterator>>& pool)
+{
+    using value_type = std::iter_value_t<Iterator>;
+    constexpr auto block_size = sample_sort_block_size_v<value_type>;
+    constexpr auto none = std::numeric_limits<std::size_t>::max();
+
+    const auto wanted_buckets =
+        std::clamp(std::bit_floor(static_cast<std::size_t>(size / (4 * block_size))), std::size_t{2}, sample_sort_max_buckets);
+    const auto tree = choose_splitters(begin, size, wanted_buckets, comp);
+    const auto buckets = tree.buckets();
+
+    /* Stripes consist of whole blocks, only the last block of the range may be shorter */
+    const auto blocks = static_cast<std::size_t>((size + block_size - 1) / block_size);
+    std::vector<sample_sort_stripe<value_type>> stripe_states(std::min(stripes, blocks));
+    for (std::size_t stripe = 0; stripe < stripe_states.size(); ++stripe)
+    {
+        stripe_states[stripe].begin = static_cast<std::ptrdiff_t>(blocks * stripe / stripe_states.size()) * block_size;
+        stripe_states[stripe].end = std::min(size, static_cast<std::ptrdiff_t>(blocks * (stripe + 1) / stripe_states.size()) * block_size);
+        stripe_states[stripe].buffers = pool.acquire();
+    }
+
+    std::vector<std::uint16_t> block_buckets(blocks);
+    tbb::parallel_for(std::size_t{0}, stripe_states.size(),
+                      [&](std::size_t stripe) { classify_stripe(begin, tree, block_size, stripe_states[stripe], block_buckets.data()); });
+
+    /* Bucket boundaries and the number of blocks of every bucket */
+    std::vector<std::ptrdiff_t> bounds(buckets + 1);
+    std::vector<std::size_t> full_blocks(buckets);
+    for (const auto& stripe : stripe_states)
+    {
+        for (std::size_t bucket = 0; bucket < buckets; ++bucket)
+        {
+            bounds[bucket + 1] += static_cast<std::ptrdiff_t>(stripe.buffers[bucket].size());
+        }
+        for (auto block = stripe.begin / block_size; block < stripe.written / block_size; ++block)
+        {
+            const auto bucket = block_buckets[static_cast<std::size_t>(block)];
+            bounds[bucket + 1] += block_size;
+            ++full_blocks[bucket];
+        }
+    }
+    for (std::size_t bucket = 0; bucket < buckets; ++bucket)
+    {
+        bounds[bucket + 1] += bounds[bucket];
+    }
+
+    /*
+     * Blocks of a bucket go to consecutive blocks from the first block boundary inside the bucket. They fit before the
+     * first boundary inside the next bucket, but the last of them may cross into it.
+     */
+    const auto first_block_of = [&](std::size_t bucket) { return static_cast<std::size_t>((bounds[bucket] + block_size - 1) / block_size); };
+    std::vector<std::size_t> target(blocks, none);
+    std::vector<std::size_t> origin(blocks, none);
+    {
+        std::vector<std::size_t> placed(buckets);
+        for (const auto& stripe : stripe_states)
+        {
+            const auto last = static_cast<std::size_t>(stripe.written / block_size);
+            for (auto block = static_cast<std::size_t>(stripe.begin / block_size); block < last; ++block)
+            {
+                const auto bucket = block_buckets[block];
+                target[block] = first_block_of(bucket) + placed[bucket]++;
+                origin[target[block]] = block;
+            }
+        }
+    }
+
+    /* Chains start from the empty blocks which receive a block and are followed backwards, the remaining moves form cycles */
+    std::vector<std::size_t> sequence_blocks;
+    std::vector<block_moves> sequences;
+    sequence_blocks.reserve(blocks);
+    for (std::size_t block = 0; block < blocks; ++block)
+    {
+        if (origin[block] != none && target[block] == none)
+        {
+            const auto first = sequence_blocks.size();
+            for (auto current = block; current != none; current = std::exchange(origin[current], none))
+            {
+                sequence_blocks.push_back(current);
+            }
+            std::reverse(sequence_blocks.begin() + static_cast<std::ptrdiff_t>(first), sequence_blocks.end());
+            sequences.push_back({first, sequence_blocks.size(), none});
+        }
+    }
+    for (std::size_t block = 0; block < blocks; ++block)
+    {
+        if (target[block] != none && target[block] != block && origin[block] != none)
+        {
+            const auto first = sequence_blocks.size();
+            for (auto current = block; origin[current] != none; current = target[current])
+            {
+                sequence_blocks.push_back(current);
+                origin[current] = none;
+            }
+            sequences.push_back({first, sequence_blocks.size(), first});
+        }
+    }
+
+    /*
+     * A block meant for the last block of a range which does not end on a block boundary waits in a buffer until the
+     * cleanup. Stripes write whole blocks only, so that block never holds one after the classification.
+     */
+    const auto tail_block = size % block_size != 0 ? blocks - 1 : none;
+    const auto tail_begin = static_cast<std::ptrdiff_t>(blocks - 1) * block_size;
+    std::vector<value_type> tail;
+
+    const auto block_at = [&](std::size_t block) { return begin + static_cast<std::ptrdiff_t>(block) * block_size; };
+    const auto save_block = [&](std::size_t block, std::vector<value_type>& saved)
+    { saved.assign(std::make_move_iterator(block_at(block)), std::make_move_iterator(block_at(block) + block_size)); };
+    const auto restore_block = [&](std::vector<value_type>& saved, std::size_t block)
+    {
+        if (block == tail_block)
+        {
+            tail.swap(saved);
+        }
+        else
+        {
+            std::move(saved.begin(), saved.end(), block_at(block));
+        }
+        saved.clear();
+    };
+
+    /* Moves the blocks of a sequence to their successors from the back, its last block has to be saved or empty */
+    const auto shift_blocks = [&](const block_moves& moves)
+    {
+        for (auto index = moves.end - 1; index > moves.begin; --index)
+        {
+            const auto from = sequence_blocks[index - 1];
+            const auto to = sequence_blocks[index];
+            if (to == tail_block)
+            {
+                save_block(from, tail);
+            }
+            else
+            {
+                std::move(block_at(from), block_at(from) + block_size, block_at(to));
+            }
+        }
+    };
+
+    /* Short sequences are moved whole by one task, long ones are cut into parts which are moved at the same time */
+    const auto part_size = std::max(sample_sort_min_moves, sequence_blocks.size() / (4 * stripe_states.size()));
+    std::vector<block_moves> whole;
+    std::vector<block_moves> parts;
+    for (const auto& sequence : sequences)
+    {
+        if (sequence.end - sequence.begin <= part_size)
+        {
+            whole.push_back(sequence);
+            continue;
+        }
+        for (auto first = sequence.begin; first < sequence.end; first += part_size)
+        {
+            const auto last = std::min(first + part_size, sequence.end);
+            parts.push_back({first, last, last < sequence.end ? last : sequence.next});
+        }
+    }
+
+    tbb::parallel_for(tbb::blocked_range<std::size_t>{0, whole.size()},
+                      [&](const auto& range)
+                      {
+                          std::vector<value_type> saved;
+                          for (auto index = range.begin(); index != range.end(); ++index)
+                          {
+                              const auto& sequence = whole[index];
+                              if (sequence.next != none)
+                              {
+                                  save_block(sequence_blocks[sequence.end - 1], saved);
+                              }
+                              shift_blocks(sequence);
+                              if (sequence.next != none)
+                              {
+                                  restore_block(saved, sequence_blocks[sequence.next]);
+                              }
+                          }
+                      });
+
+    /* Every part saves its last block and shifts the others, the saved blocks move on once all parts have shifted */
+    std::vector<std::vector<value_type>> carried(parts.size());
+    tbb::parallel_for(std::size_t{0}, parts.size(),
+                      [&](std::size_t index)
+                      {
+                          if (parts[index].next != none)
+                          {
+                              save_block(sequence_blocks[parts[index].end - 1], carried[index]);
+                          }
+                          shift_blocks(parts[index]);
+                      });
+    tbb::parallel_for(std::size_t{0}, parts.size(),
+                      [&](std::size_t index)
+                      {
+                          if (parts[index].next != none)
+                          {
+                              restore_block(carried[index], sequence_blocks[parts[index].next]);
+                          }
+                      });
+
+    /*
+     * Cleanup. The part of the last block of a bucket beyond the bucket lies where the next buckets start, so it is moved
+     * aside first. Then the gaps before the first and after the last block of every bucket are filled with those elements
+     * and with the partial blocks of the stripes.
+     */
+    const auto blocks_begin = [&](std::size_t bucket) { return static_cast<std::ptrdiff_t>(first_block_of(bucket)) * block_size; };
+    const auto blocks_end = [&](std::size_t bucket)
+    { return static_cast<std::ptrdiff_t>(first_block_of(bucket) + full_blocks[bucket]) * block_size; };
+
+    std::vector<std::vector<value_type>> overflows(buckets);
+    tbb::parallel_for(std::size_t{0}, buckets,
+                      [&](std::size_t bucket)
+                      {
+                          const auto last = blocks_end(bucket);
+                          if (full_blocks[bucket] == 0 || last <= bounds[bucket + 1])
+                          {
+                              return;
+                          }
+
+                          if (tail_block != none && last > size)
+                          {
+                              const auto inside = std::max(tail_begin, bounds[bucket + 1]) - tail_begin;
+                              std::move(tail.begin(), tail.begin() + inside, begin + tail_begin);
+                              overflows[bucket].assign(std::make_move_iterator(tail.begin() + inside), std::make_move_iterator(tail.end()));
+                          }
+                          else
+                          {
+                              overflows[bucket].assign(std::make_move_iterator(begin + bounds[bucket + 1]), std::make_move_iterator(begin + last));
+                          }
+                      });
+
+    tbb::parallel_for(std::size_t{0}, buckets,
+                      [&](std::size_t bucket)
+                      {
+                          auto position = bounds[bucket];
+                          const auto gap_end = full_blocks[bucket] == 0 ? bounds[bucket + 1] : blocks_begin(bucket);
+                          const auto refill = [&](std::vector<value_type>& source)
+                          {
+                              for (auto& element : source)
+                              {
+                                  if (position == gap_end)
+                                  {
+                                      position = blocks_end(bucket);
+                                  }
+                                  begin[position++] = std::move(element);
+                              }
+                              source.clear();
+                          };
+
+                          refill(overflows[bucket]);
+                          for (auto& stripe : stripe_states)
+                          {
+                              refill(stripe.buffers[bucket]);
+                          }
+                      });
+
+    for (auto& stripe : stripe_states)
+    {
+        pool.release(std::move(stripe.buffers));
+    }
+
+    tbb::parallel_for(std::size_t{0}, buckets,
+                      [&](std::size_t bucket)
+                      {
+                          if (!tree.is_equality_bucket(bucket))
+                          {
+                              parallel_sample_sort(begin + bounds[bucket], begin + bounds[bucket + 1], comp, pool);
+                          }
+                      });
+}
+
+template <typename Iterator, typename Compare>
+void parallel_sample_sort(Iterator begin, Iterator end, Compare& comp, sample_sort_buffers<std::iter_value_t<Iterator>>& pool)
+{
+    if constexpr (!std::random_access_iterator<Iterator> || !std::is_copy_constructible_v<std::iter_value_t<Iterator>>)
+    {
+        /* Splitters are copies of elements */
+        pdq_sort(begin, end, comp);
+    }
+    else
+    {
+        const auto size = end - begin;
+        const auto stripes = std::min(static_cast<std::size_t>(tbb::this_task_arena::max_concurrency()),
+                                      static_cast<std::size_t>(size / sample_sort_stripe_size));
+        if (stripes < 2)
+        {
+            pdq_sort(begin, end, comp);
+            return;
+        }
+
+        sample_sort_level(begin, size, stripes, comp, pool);
+    }
+}
+
+template <typename Iterator, typename Compare>
+void parallel_sample_sort(Iterator begin, Iterator end, Compare& comp)
+{
+    sample_sort_buffers<std::iter_value_t<Iterator>> pool;
+    parallel_sample_sort(begin, end, comp, pool);
+}
+}  // namespace detail
+
+/*
+ * Uses the threads of the current TBB task arena, the comparator and the projection are called from several threads at once.
+ * Not stable. Ranges that are too small to split between threads, or whose elements cannot be copied, are sorted by pdq_sort,
+ * lists by list_sort.
+ */
+template <typename Range, typename = detail::enable_if_sortable_t<Range>>
+void parallel_sample_sort(Range& range)
+{
+    if constexpr (detail::is_list_v<Range>)
+    {
+        list_sort(range);
+    }
+    else
+    {
+        std::less<> comp;
+        detail::parallel_sample_sort(detail::unwrap(std::begin(range)), detail::unwrap(std::end(range)), comp);
+    }
+}
+
+template <typename Range, typename Compare, typename Projection = std::identity,
+          typename = detail::enable_if_sortable_by_t<Range, Compare, Projection>>
+void parallel_sample_sort(Range& range, Compare comp, Projection proj = {})
+{
+    if constexpr (detail::is_list_v<Range>)
+    {
+        list_sort(range, comp, proj);
+    }
+    else
+    {
+        auto compare = detail::make_compare(comp, proj);
+        detail::parallel_sample_sort(detail::unwrap(std::begin(range)), detail::unwrap(std::end(range)), compare);
+    }
+}
+}  // namespace algorithm
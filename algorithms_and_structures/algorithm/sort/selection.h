@@ -0,0 +1,324 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "heap_sort.h"
+#include "quick_sort.h"
+#include "sorting_network.h"
+#include "detail/compare.h"
+#include "detail/iterator.h"
+#include "detail/simd_filter.h"
+#include "detail/type_traits.h"
+
+/*
+ * Selection finds the k smallest elements without sorting the rest.
+ * nth_element is introselect: the quick sort partition, but only the part holding the wanted position is partitioned further,
+ * which is O(n) on average. Long ranges take the pivot by Floyd and Rivest from a sample around the wanted rank, so usually
+ * a couple of partitions suffice, and too many unbalanced partitions fall back to a heap selection.
+ * partial_sort and top_k of a few elements keep the k smallest in a maximal heap, O(n log k): an element enters only when it is
+ * smaller than the root, and contiguous numbers look for such elements with vectorized comparisons against the root.
+ * Selections of more elements partition instead.
+ */
+namespace algorithm
+{
+namespace detail
+{
+/* Ranges above this size take the pivot from a sample instead of the ninther */
+constexpr std::ptrdiff_t floyd_rivest_threshold = 600;
+
+/* Heaps of the selections are sifted from the root only, a 4-ary one is half as deep as a binary one */
+constexpr std::size_t selection_heap_arity = 4;
+
+/*
+ * Random access ranges keep a heap of at most one element per this many elements. A larger heap takes in too many elements,
+ * selecting the position by partitions and sorting the part before it is faster then (32-bit integers and strings, x86-64).
+ */
+constexpr std::ptrdiff_t partial_sort_heap_ratio = 1024;
+
+/*
+ * First element from current on ordered before the threshold. Contiguous numbers of the threshold's own type are searched
+ * by the vectorized kernel; other types are compared by comp, the kernel would convert the threshold to the element type.
+ */
+template <typename Iterator, typename T, typename Compare>
+constexpr Iterator find_before(Iterator current, Iterator end, const T& threshold, Compare& comp)
+{
+    if constexpr (is_simd_filterable_v<Iterator> && std::is_same_v<std::iter_value_t<Iterator>, T> && is_natural_order_v<Compare>)
+    {
+        const auto kernel = std::is_constant_evaluated() ? nullptr : simd_find_below_kernel<std::iter_value_t<Iterator>>();
+        if (kernel)
+        {
+            const auto first = std::to_address(current);
+            return std::next(current, kernel(first, std::to_address(end), threshold) - first);
+        }
+    }
+    return std::find_if(current, end, [&threshold, &comp](const auto& value) { return comp(value, threshold); });
+}
+
+/* Leaves the heap_size smallest elements in a maximal heap on [begin, middle), the others behind it in no particular order */
+template <std::size_t Arity, typename Iterator, typename Compare>
+constexpr void heap_select(Iterator begin, Iterator middle, Iterator end, std::ptrdiff_t heap_size, Compare& comp)
+{
+    detail::make_heap<Arity>(begin, heap_size, comp);
+    for (auto current = find_before(middle, end, *begin, comp); current != end; current = find_before(std::next(current), end, *begin, comp))
+    {
+        /* The root is no longer among the smallest, it takes the place of the element which replaces it */
+        auto value = std::ranges::iter_move(current);
+        *current = std::ranges::iter_move(begin);
+        heapify<Arity>(begin, heap_size, 0, std::move(value), comp);
+    }
+}
+
+template <typename Iterator, typename Compare>
+constexpr void introselect(Iterator begin, Iterator end, std::ptrdiff_t size, std::ptrdiff_t nth, std::ptrdiff_t depth_limit, Compare& comp);
+
+/*
+ * Places the pivot on the last position: the element of the wanted rank within a sample of about n^(2/3) elements around nth,
+ * selected recursively. The sample leans a few standard deviations towards the middle of the range, so the wanted position
+ * lands in a short part next to the pivot with high probability.
+ */
+template <typename Iterator, typename Compare>
+void floyd_rivest_pivot(Iterator begin, Iterator end, std::ptrdiff_t size, std::ptrdiff_t nth, std::ptrdiff_t depth_limit, Compare& comp)
+{
+    const auto n = static_cast<double>(size);
+    const auto rank = static_cast<double>(nth + 1);
+    const auto log_size = std::log(n);
+    const auto sample = 0.5 * std::exp(2.0 * log_size / 3.0);
+    const auto deviation = 0.5 * std::sqrt(log_size * sample * (n - sample) / n) * (rank < n / 2 ? -1.0 : 1.0);
+
+    const auto below = static_cast<std::ptrdiff_t>(rank * sample / n - deviation);
+    const auto above = static_cast<std::ptrdiff_t>((n - rank) * sample / n + deviation);
+    const auto sample_begin = std::clamp(nth - below, std::ptrdiff_t{0}, nth);
+    const auto sample_end = std::clamp(nth + above + 1, nth + 1, size);
+    introselect(begin + sample_begin, begin + sample_end, sample_end - sample_begin, nth - sample_begin, depth_limit, comp);
+
+    /* The partition expects the pivot on the last position */
+    std::iter_swap(begin + nth, std::prev(end));
+}
+
+/* Moves the element of position nth in sorted order there, no element before it is larger and none after it is smaller */
+template <typename Iterator, typename Compare>
+constexpr void introselect(Iterator begin, Iterator end, std::ptrdiff_t size, std::ptrdiff_t nth, std::ptrdiff_t depth_limit, Compare& comp)
+{
+    const auto first = begin;
+    while (size > quick_sort_small_threshold)
+    {
+        /* Too many unbalanced partitions, the heap selection keeps O(n log n) */
+        if (depth_limit == 0)
+        {
+            if constexpr (std::random_access_iterator<Iterator>)
+            {
+                heap_select<selection_heap_arity>(begin, std::next(begin, nth + 1), end, nth + 1, comp);
+                std::iter_swap(begin, std::next(begin, nth));
+            }
+            else
+            {
+                heap_sort(begin, end, comp);
+            }
+            return;
+        }
+        --depth_limit;
+
+        if constexpr (std::random_access_iterator<Iterator>)
+        {
+            if (size > floyd_rivest_threshold && !std::is_constant_evaluated())
+            {
+                floyd_rivest_pivot(begin, end, size, nth, depth_limit, comp);
+            }
+            else
+            {
+                choose_pivot(begin, end, size, comp);
+            }
+        }
+        else
+        {
+            choose_pivot(begin, end, size, comp);
+        }
+
+        /*
+         * No element of a part right of an earlier pivot is smaller than that pivot. If the new pivot is not larger either,
+         * the partition would only split off the copies of it one at a time, so gather them all on the left at once.
+         */
+        if (begin != first && !comp(*std::prev(begin), *std::prev(end)))
+        {
+            auto lower = std::prev(begin);
+            auto equal_end = std::partition(begin, end, [lower, &comp](const auto& value) { return !comp(*lower, value); });
+            const auto equal_size = std::distance(begin, equal_end);
+            if (nth < equal_size)
+            {
+                return;
+            }
+            begin = equal_end;
+            size -= equal_size;
+            nth -= equal_size;
+            continue;
+        }
+
+        auto pivot = vectorized_partition(begin, end, size, comp);
+        const auto left_size = std::distance(begin, pivot);
+        if (nth == left_size)
+        {
+            return;
+        }
+
+        /* Only the part holding the wanted position is partitioned further */
+        if (nth < left_size)
+        {
+            end = pivot;
+            size = left_size;
+        }
+        else
+        {
+            begin = std::next(pivot);
+            size -= left_size + 1;
+            nth -= left_size + 1;
+        }
+    }
+
+    small_sort(begin, end, size, comp);
+}
+
+template <typename Iterator, typename Compare = std::less<>>
+constexpr void nth_element(Iterator begin, Iterator nth, Iterator end, Compare comp = {})
+{
+    const auto size = std::distance(begin, end);
+    const auto position = std::distance(begin, nth);
+    if (position >= size)
+    {
+        return;
+    }
+
+    /* Allow 2 * log2(n) levels of partitioning before falling back to the heap selection */
+    const auto depth_limit = 2 * static_cast<std::ptrdiff_t>(std::bit_width(static_cast<std::size_t>(size)) - 1);
+    introselect(begin, end, size, position, depth_limit, comp);
+}
+
+/* Sorts the smallest elements into [begin, middle), the others are left behind them in no particular order */
+template <typename Iterator, typename Compare = std::less<>>
+constexpr void partial_sort(Iterator begin, Iterator middle, Iterator end, Compare comp = {})
+{
+    const auto heap_size = std::distance(begin, middle);
+    if (heap_size == 0)
+    {
+        return;
+    }
+
+    /* A heap over a list walks the nodes on every step, and a large heap is slower than the partitions */
+    const auto size = heap_size + std::distance(middle, end);
+    if (!std::random_access_iterator<Iterator> || heap_size > size / partial_sort_heap_ratio)
+    {
+        auto last = std::prev(middle);
+        detail::nth_element(begin, last, end, comp);
+        quick_sort(begin, last, comp);
+        return;
+    }
+
+    heap_select<selection_heap_arity>(begin, middle, end, heap_size, comp);
+    detail::sort_heap<selection_heap_arity>(begin, heap_size, comp);
+}
+
+/* Positions are counted from begin, those past the end mean the end */
+template <typename Iterator>
+constexpr Iterator position_or_end(Iterator begin, Iterator end, std::size_t position)
+{
+    const auto size = static_cast<std::size_t>(std::distance(begin, end));
+    return std::next(begin, static_cast<std::ptrdiff_t>(std::min(position, size)));
+}
+
+template <typename Iterator, typename Compare>
+std::vector<std::iter_value_t<Iterator>> top_k(Iterator begin, Iterator end, std::size_t k, Compare comp)
+{
+    using value_type = std::iter_value_t<Iterator>;
+
+    const auto size = static_cast<std::size_t>(std::distance(begin, end));
+    const auto count = std::min(k, size);
+    if constexpr (std::random_access_iterator<Iterator>)
+    {
+        /* Too many elements would pass through the heap, select in a copy of the range */
+        if (count > size / partial_sort_heap_ratio)
+        {
+            std::vector<value_type> copy(begin, end);
+            detail::partial_sort(copy.data(), copy.data() + count, copy.data() + size, comp);
+            copy.erase(std::next(copy.begin(), static_cast<std::ptrdiff_t>(count)), copy.end());
+            return copy;
+        }
+    }
+
+    std::vector<value_type> best;
+    best.reserve(count);
+    auto current = begin;
+    for (; best.size() < count; ++current)
+    {
+        best.push_back(*current);
+    }
+    if (best.empty())
+    {
+        return best;
+    }
+
+    /* The range is only read, copies of the elements smaller than the root replace it */
+    const auto heap_size = static_cast<std::ptrdiff_t>(count);
+    detail::make_heap<selection_heap_arity>(best.data(), heap_size, comp);
+    for (current = find_before(current, end, best.front(), comp); current != end; current = find_before(std::next(current), end, best.front(), comp))
+    {
+        heapify<selection_heap_arity>(best.data(), heap_size, 0, value_type(*current), comp);
+    }
+    detail::sort_heap<selection_heap_arity>(best.data(), heap_size, comp);
+    return best;
+}
+}  // namespace detail
+
+/* Puts the element which sorting would place on position nth there, smaller or equal elements before it and the rest after it */
+template <typename Range, typename = detail::enable_if_sortable_t<Range>>
+constexpr void nth_element(Range& range, std::size_t nth)
+{
+    auto begin = detail::unwrap(std::begin(range));
+    auto end = detail::unwrap(std::end(range));
+    detail::nth_element(begin, detail::position_or_end(begin, end, nth), end);
+}
+
+template <typename Range, typename Compare, typename Projection = std::identity,
+          typename = detail::enable_if_sortable_by_t<Range, Compare, Projection>>
+constexpr void nth_element(Range& range, std::size_t nth, Compare comp, Projection proj = {})
+{
+    auto begin = detail::unwrap(std::begin(range));
+    auto end = detail::unwrap(std::end(range));
+    detail::nth_element(begin, detail::position_or_end(begin, end, nth), end, detail::make_compare(comp, proj));
+}
+
+/* Sorts the count smallest elements to the front, unstable; the order of the others is unspecified */
+template <typename Range, typename = detail::enable_if_sortable_t<Range>>
+constexpr void partial_sort(Range& range, std::size_t count)
+{
+    auto begin = detail::unwrap(std::begin(range));
+    auto end = detail::unwrap(std::end(range));
+    detail::partial_sort(begin, detail::position_or_end(begin, end, count), end);
+}
+
+template <typename Range, typename Compare, typename Projection = std::identity,
+          typename = detail::enable_if_sortable_by_t<Range, Compare, Projection>>
+constexpr void partial_sort(Range& range, std::size_t count, Compare comp, Projection proj = {})
+{
+    auto begin = detail::unwrap(std::begin(range));
+    auto end = detail::unwrap(std::end(range));
+    detail::partial_sort(begin, detail::position_or_end(begin, end, count), end, detail::make_compare(comp, proj));
+}
+
+/*
+ * Copies of the k elements ordered first by comp(proj(a), proj(b)), in that order: the k smallest by default,
+ * the k largest with std::greater<>{}. The range is only read, so it may be const.
+ */
+template <typename Range, typename Compare = std::less<>, typename Projection = std::identity,
+          typename = detail::enable_if_sortable_by_t<const Range, Compare, Projection>>
+std::vector<detail::sortable_value_t<const Range>> top_k(const Range& range, std::size_t k, Compare comp = {}, Projection proj = {})
+{
+    return detail::top_k(detail::unwrap(std::begin(range)), detail::unwrap(std::end(range)), k, detail::make_compare(comp, proj));
+}
+}  // namespace algorithm
@@ -1,5 +1,14 @@
 #pragma once
 
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_reduce.h>
+#include "detail/compare.h"
+#include "detail/execution.h"
+#include "detail/iterator.h"
 #include "detail/type_traits.h"
 
 /* Operation iterator +/- n requires random access iterator, we have bidirectorial one so we use std::next, std::prev */
@@ -7,31 +16,103 @@ namespace algorithm
 {
 namespace detail
 {
-template <typename Iterator>
-void selection_sort(Iterator begin, Iterator end)
+template <typename Iterator, typename Compare = std::less<>>
+void selection_sort(Iterator begin, Iterator end, Compare comp = {})
 {
    for (auto left = begin; left != std::prev(end); ++left)
    {
       auto min = left;
-      for (auto right = left + 1; right != end; ++right)
+      for (auto right = std::next(left); right != end; ++right)
       {
          /* Find minimal element in the right side of the range */
-         if (*right < *min)
+         if (comp(*right, *min))
          {
             min = right;
          }
       }
       /* Move minimal element to the possible left position of the range */
-      std::swap(*left, *min);
+      std::iter_swap(left, min);
    }
 }
+
+/* Minimum searches over fewer elements than this are not split between threads */
+constexpr std::ptrdiff_t parallel_selection_sort_threshold = std::ptrdiff_t{1} << 13;
+
+/*
+ * The first of the smallest elements. Numbers are searched in two passes without branches, the smallest value first and then
+ * its position, both loops vectorize.
+ */
+template <typename Iterator, typename Compare>
+Iterator unsequenced_min_element(Iterator begin, Iterator end, Compare& comp)
+{
+    using value_type = std::iter_value_t<Iterator>;
+
+    if constexpr (std::is_arithmetic_v<value_type> && is_natural_order_v<Compare>)
+    {
+        auto min = *begin;
+        for (auto it = std::next(begin); it != end; ++it)
+        {
+            const value_type value = *it;
+            min = value < min ? value : min;
+        }
+
+        /* Not found only when the first element is a NaN, which no comparison moves */
+        auto position = std::find(begin, end, min);
+        return position != end ? position : std::min_element(begin, end, comp);
+    }
+    else
+    {
+        return std::min_element(begin, end, comp);
+    }
+}
+
+/* The first of the smallest elements, the range is cut into parts whose minimums are found on separate threads */
+template <typename Iterator, typename Compare>
+Iterator parallel_min_element(Iterator begin, Iterator end, Compare& comp)
+{
+    return tbb::parallel_reduce(
+        tbb::blocked_range<Iterator>{begin, end, parallel_selection_sort_threshold / 4}, end,
+        [&](const auto& range, Iterator min)
+        {
+            auto part_min = unsequenced_min_element(range.begin(), range.end(), comp);
+            return min == end || comp(*part_min, *min) || (!comp(*min, *part_min) && part_min < min) ? part_min : min;
+        },
+        [&](Iterator left, Iterator right)
+        {
+            if (left == end || right == end)
+            {
+                return left == end ? right : left;
+            }
+            return comp(*right, *left) || (!comp(*left, *right) && right < left) ? right : left;
+        });
+}
+
+/* Selection sort whose search for the minimum vectorizes under the unsequenced policies and runs on several threads under the parallel ones */
+template <typename ExecutionPolicy, typename Iterator, typename Compare>
+void selection_sort(const ExecutionPolicy&, Iterator begin, Iterator end, Compare comp)
+{
+    if constexpr (!std::random_access_iterator<Iterator> || !(is_parallel_policy_v<ExecutionPolicy> || is_unsequenced_policy_v<ExecutionPolicy>))
+    {
+        selection_sort(begin, end, comp);
+    }
+    else
+    {
+        for (auto left = begin; left != std::prev(end); ++left)
+        {
+            const auto min = is_parallel_policy_v<ExecutionPolicy> && end - left >= parallel_selection_sort_threshold
+                                 ? parallel_min_element(left, end, comp)
+                                 : unsequenced_min_element(left, end, comp);
+            std::iter_swap(left, min);
+        }
+    }
+}
 }  // namespace detail
 
 template <typename Range, typename = detail::enable_if_sortable_t<Range>>
 void selection_sort(Range& range)
 {
-    auto begin = std::begin(range);
-    auto end = std::end(range);
+    auto begin = detail::unwrap(std::begin(range));
+    auto end = detail::unwrap(std::end(range));
 
     if (begin == end)
     {
@@ -40,5 +121,49 @@ void selection_sort(Range& range)
 
     detail::selection_sort(begin, end);
 }
-}  // namespace algorithm
 
+template <typename Range, typename Compare, typename Projection = std::identity,
+          typename = detail::enable_if_sortable_by_t<Range, Compare, Projection>>
+void selection_sort(Range& range, Compare comp, Projection proj = {})
+{
+    auto begin = detail::unwrap(std::begin(range));
+    auto end = detail::unwrap(std::end(range));
+
+    if (begin == end)
+    {
+        return;
+    }
+
+    detail::selection_sort(begin, end, detail::make_compare(comp, proj));
+}
+
+/* Finds the minimums with vectorized loops under the unseq policy and on several threads under the parallel ones, see detail/execution.h */
+template <typename ExecutionPolicy, typename Range, typename = detail::enable_if_execution_policy_t<ExecutionPolicy, Range>>
+void selection_sort(ExecutionPolicy&& policy, Range& range)
+{
+    auto begin = detail::unwrap(std::begin(range));
+    auto end = detail::unwrap(std::end(range));
+
+    if (begin == end)
+    {
+        return;
+    }
+
+    detail::selection_sort(policy, begin, end, std::less<>{});
+}
+
+template <typename ExecutionPolicy, typename Range, typename Compare, typename Projection = std::identity,
+          typename = detail::enable_if_execution_policy_by_t<ExecutionPolicy, Range, Compare, Projection>>
+void selection_sort(ExecutionPolicy&& policy, Range& range, Compare comp, Projection proj = {})
+{
+    auto begin = detail::unwrap(std::begin(range));
+    auto end = detail::unwrap(std::end(range));
+
+    if (begin == end)
+    {
+        return;
+    }
+
+    detail::selection_sort(policy, begin, end, detail::make_compare(comp, proj));
+}
+}  // namespace algorithm
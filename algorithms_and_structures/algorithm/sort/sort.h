@@ -1,11 +1,22 @@
 #pragma once
 
+#include "adaptive_sort.h"
+#include "argsort.h"
 #include "bubble_sort.h"
 #include "bucket_sort.h"
 #include "counting_sort.h"
 #include "heap_sort.h"
 #include "insertion_sort.h"
+#include "list_sort.h"
 #include "merge_sort.h"
+#include "pdq_sort.h"
+#include "power_sort.h"
 #include "radix_sort.h"
 #include "quick_sort.h"
+#include "sample_sort.h"
+#include "selection.h"
 #include "selection_sort.h"
+#include "sort_by_cached_key.h"
+#include "sorting_network.h"
+#include "top_k_stream.h"
+#include "zip_sort.h"
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+#include "power_sort.h"
+#include "detail/iterator.h"
+#include "detail/permutation.h"
+#include "detail/type_traits.h"
+
+/*
+ * Sort by a key which is expensive to compute, like a hash or a lowercased string. A projection would compute it again
+ * in every comparison, here the key of every element is computed once into a side buffer of (key, index) pairs.
+ * The pairs are sorted and the elements are moved to their places at the end, each of them once.
+ */
+namespace algorithm
+{
+namespace detail
+{
+template <typename Key>
+struct cached_key
+{
+    Key key;
+    std::size_t index;
+};
+
+/* Positions of the elements in the stable order of their keys, every key is computed once */
+template <typename Iterator, typename KeyOf, typename Compare>
+std::vector<std::size_t> cached_key_order(Iterator begin, Iterator end, KeyOf& key_of, Compare& comp)
+{
+    using key_type = std::remove_cvref_t<std::invoke_result_t<KeyOf&, std::iter_reference_t<Iterator>>>;
+
+    const auto size = static_cast<std::size_t>(std::distance(begin, end));
+    std::vector<cached_key<key_type>> keys;
+    keys.reserve(size);
+    for (auto it = begin; it != end; ++it)
+    {
+        keys.push_back({std::invoke(key_of, *it), keys.size()});
+    }
+
+    /* Power sort is stable, so equal keys keep the order of their elements, and it is fast on already ordered keys */
+    power_sort(keys.data(), keys.data() + size, [&comp](const auto& lhs, const auto& rhs) { return comp(lhs.key, rhs.key); });
+
+    std::vector<std::size_t> order(size);
+    for (std::size_t position = 0; position < size; ++position)
+    {
+        order[position] = keys[position].index;
+    }
+    return order;
+}
+
+template <typename Iterator, typename KeyOf, typename Compare>
+void sort_by_cached_key(Iterator begin, Iterator end, KeyOf& key_of, Compare& comp)
+{
+    auto order = cached_key_order(begin, end, key_of, comp);
+    auto position = index_positions(begin, order.size());
+    apply_permutation(order, position);
+}
+}  // namespace detail
+
+/* Stable sort by key_of(element) in the order given by comp, the key is computed once per element */
+template <typename Range, typename KeyOf, typename Compare = std::less<>, typename = detail::enable_if_sortable_by_t<Range, Compare, KeyOf>>
+void sort_by_cached_key(Range& range, KeyOf key_of, Compare comp = {})
+{
+    auto begin = detail::unwrap(std::begin(range));
+    auto end = detail::unwrap(std::end(range));
+
+    if (begin == end)
+    {
+        return;
+    }
+
+    detail::sort_by_cached_key(begin, end, key_of, comp);
+}
+}  // namespace algorithm
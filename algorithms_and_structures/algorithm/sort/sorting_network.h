@@ -0,0 +1,192 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include "insertion_sort.h"
+#include "detail/compare.h"
+#include "detail/simd_sorting_network.h"
+#include "detail/type_traits.h"
+
+/*
+ * Sorting networks for a size known at compile time: a fixed sequence of compare-exchange operations, independent of
+ * the data, so the whole sort unrolls into straight code without loops and, for numbers, without branches.
+ * Networks come from Batcher's merge exchange, which is optimal up to 8 elements and a few comparators off beyond.
+ */
+namespace algorithm
+{
+namespace detail
+{
+/* Networks are generated up to this size, larger ones lose to the usual sorts */
+constexpr std::size_t sorting_network_max_size = 32;
+
+/* Numbers are cheap to copy and compare, so networks beat insertion sort on them as base cases */
+template <typename Iterator>
+constexpr bool is_network_sortable_v = std::random_access_iterator<Iterator> && std::is_arithmetic_v<std::iter_value_t<Iterator>>;
+
+struct comparator
+{
+    std::uint8_t first;
+    std::uint8_t second;
+};
+
+/* Batcher's merge exchange (Knuth, TAOCP 5.2.2, algorithm M), visits every comparator of the network for the given size */
+template <typename Visitor>
+constexpr void merge_exchange(std::size_t size, Visitor visit)
+{
+    if (size < 2)
+    {
+        return;
+    }
+
+    const auto top = std::size_t{1} << (std::bit_width(size - 1) - 1);
+    for (auto p = top; p > 0; p /= 2)
+    {
+        auto q = top;
+        std::size_t r = 0;
+        auto d = p;
+        while (true)
+        {
+            for (std::size_t i = 0; i + d < size; ++i)
+            {
+                if ((i & p) == r)
+                {
+                    visit(i, i + d);
+                }
+            }
+            if (q == p)
+            {
+                break;
+            }
+            d = q - p;
+            q /= 2;
+            r = p;
+        }
+    }
+}
+
+template <std::size_t N>
+constexpr auto make_sorting_network()
+{
+    static_assert(N <= sorting_network_max_size, "Sorting networks are generated up to 32 elements");
+
+    constexpr auto size = []
+    {
+        std::size_t count = 0;
+        merge_exchange(N, [&](std::size_t, std::size_t) { ++count; });
+        return count;
+    }();
+
+    std::array<comparator, size> network{};
+    std::size_t index = 0;
+    merge_exchange(N, [&](std::size_t first, std::size_t second)
+                   { network[index++] = {static_cast<std::uint8_t>(first), static_cast<std::uint8_t>(second)}; });
+    return network;
+}
+
+template <std::size_t N>
+constexpr auto sorting_network_v = make_sorting_network<N>();
+
+/* Orders two elements; numbers are selected with conditional moves instead of a jump */
+template <typename Iterator, typename Compare>
+constexpr void compare_exchange(Iterator a, Iterator b, Compare& comp)
+{
+    if constexpr (std::is_arithmetic_v<std::iter_value_t<Iterator>>)
+    {
+        const auto first = *a;
+        const auto second = *b;
+        const bool swap = comp(second, first);
+        *a = swap ? second : first;
+        *b = swap ? first : second;
+    }
+    else if (comp(*b, *a))
+    {
+        std::iter_swap(a, b);
+    }
+}
+
+template <std::size_t N, typename Iterator, typename Compare, std::size_t... Index>
+constexpr void apply_sorting_network([[maybe_unused]] Iterator first, Compare& comp, std::index_sequence<Index...>)
+{
+    constexpr const auto& network = sorting_network_v<N>;
+    (compare_exchange(first + network[Index].first, first + network[Index].second, comp), ...);
+}
+
+/* Sorts [first, first + N), contiguous numbers fitting into one register are sorted inside it when compiled for it */
+template <std::size_t N, typename Iterator, typename Compare = std::less<>>
+constexpr void network_sort(Iterator first, Compare comp = {})
+{
+    using value_type = std::iter_value_t<Iterator>;
+    constexpr auto lanes = simd_network_lanes<value_type>();
+
+    if constexpr (std::contiguous_iterator<Iterator> && is_natural_order_v<Compare> && lanes / 2 < N && N <= lanes)
+    {
+        if (!std::is_constant_evaluated())
+        {
+            simd_network_sort<N>(std::to_address(first));
+            return;
+        }
+    }
+    apply_sorting_network<N>(first, comp, std::make_index_sequence<sorting_network_v<N>.size()>{});
+}
+
+template <typename Iterator, typename Compare, std::size_t... Size>
+constexpr void network_sort(Iterator first, std::ptrdiff_t size, Compare& comp, std::index_sequence<Size...>)
+{
+    /* Compiles to a jump table over the unrolled networks */
+    static_cast<void>(((size == static_cast<std::ptrdiff_t>(Size) && (network_sort<Size>(first, comp), true)) || ...));
+}
+
+/* Sorts a short range whose size is known only at runtime, the base case of other sorts */
+template <typename Iterator, typename Compare = std::less<>>
+constexpr void small_sort(Iterator begin, Iterator end, std::ptrdiff_t size, Compare comp = {})
+{
+    if constexpr (is_network_sortable_v<Iterator>)
+    {
+        if (size <= static_cast<std::ptrdiff_t>(sorting_network_max_size))
+        {
+            network_sort(begin, size, comp, std::make_index_sequence<sorting_network_max_size + 1>{});
+            return;
+        }
+    }
+
+    if (size > 1)
+    {
+        insertion_sort(begin, end, comp);
+    }
+}
+}  // namespace detail
+
+template <typename T, std::size_t N>
+constexpr void network_sort(std::array<T, N>& array)
+{
+    detail::network_sort<N>(array.begin());
+}
+
+template <typename T, std::size_t N, typename Compare, typename Projection = std::identity,
+          typename = detail::enable_if_sortable_by_t<std::array<T, N>, Compare, Projection>>
+constexpr void network_sort(std::array<T, N>& array, Compare comp, Projection proj = {})
+{
+    detail::network_sort<N>(array.begin(), detail::make_compare(comp, proj));
+}
+
+/* Sorts a fixed size piece of a range, for example std::span<int, 8>{values.data() + offset, 8} */
+template <typename T, std::size_t N, typename = std::enable_if_t<N != std::dynamic_extent>>
+constexpr void network_sort(std::span<T, N> range)
+{
+    detail::network_sort<N>(range.begin());
+}
+
+template <typename T, std::size_t N, typename Compare, typename Projection = std::identity,
+          typename = std::enable_if_t<N != std::dynamic_extent && detail::is_sortable_by_v<std::span<T, N>, Compare, Projection>>>
+constexpr void network_sort(std::span<T, N> range, Compare comp, Projection proj = {})
+{
+    detail::network_sort<N>(range.begin(), detail::make_compare(comp, proj));
+}
+}  // namespace algorithm
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <optional>
+#include <utility>
+#include <vector>
+#include "quick_sort.h"
+#include "selection.h"
+#include "detail/iterator.h"
+#include "detail/type_traits.h"
+
+/*
+ * Online top-k: keeps the K first values in the order of Compare (the K smallest by default) out of a stream too long
+ * to be stored. Candidates are appended to a buffer of 2K values, and a full buffer is compacted by nth_element down to
+ * the best K, which costs O(K) once per K accepted values. After the first compaction the K-th best value is a threshold
+ * and values not ordered before it are rejected by a single comparison; batches of contiguous numbers in natural order
+ * are scanned for candidates by the vectorized kernel. Memory stays at 2K values however long the stream gets.
+ * The kept values also give exact quantiles of the stream's tail, down to rank K.
+ */
+namespace algorithm
+{
+template <typename T, std::size_t K, typename Compare = std::less<>>
+class top_k_stream
+{
+    static_assert(K > 0, "Stream has to keep at least one value");
+
+    public:
+    explicit top_k_stream(Compare comp = {}) : comp_(comp)
+    {
+        buffer_.reserve(2 * K);
+    }
+
+    /* Amortized O(1), and a single comparison for a rejected value */
+    void push(const T& value)
+    {
+        ++seen_;
+        if (accepts(value))
+        {
+            append(value);
+        }
+    }
+
+    void push(T&& value)
+    {
+        ++seen_;
+        if (accepts(value))
+        {
+            append(std::move(value));
+        }
+    }
+
+    /* Offers every value of the range, a vector or a span of numbers is filtered by vectorized comparisons */
+    template <typename Range, typename = detail::enable_if_sortable_t<const Range>>
+    void push_range(const Range& values)
+    {
+        auto begin = detail::unwrap(std::begin(values));
+        auto end = detail::unwrap(std::end(values));
+        seen_ += static_cast<std::uint64_t>(std::distance(begin, end));
+        offer(begin, end);
+    }
+
+    /* Adds the values of another stream, e.g. one filled by another thread; the result is the top-k of both streams */
+    void merge(const top_k_stream& other)
+    {
+        seen_ += other.seen_;
+        offer(other.buffer_.begin(), other.buffer_.end());
+    }
+
+    /* The current top-k in no particular order, O(K) */
+    std::vector<T> top() const
+    {
+        auto values = buffer_;
+        if (values.size() > K)
+        {
+            detail::nth_element(values.data(), values.data() + K - 1, values.data() + values.size(), comp_);
+            values.erase(std::next(values.begin(), K), values.end());
+        }
+        return values;
+    }
+
+    /* The current top-k ordered by the comparator, O(K log K) */
+    std::vector<T> sorted() const
+    {
+        auto values = top();
+        detail::quick_sort(values.data(), values.data() + values.size(), comp_);
+        return values;
+    }
+
+    /*
+     * Quantile of every value seen so far, the value of rank floor(q * (seen - 1)) in the order of the comparator, O(K).
+     * It is exact, but only ranks below K are kept, so it answers for the tail the comparator puts first: with K = 1000
+     * the p99.9 of a million latencies comes from top_k_stream<double, 1000, std::greater<>> as quantile(0.001).
+     * Deeper quantiles return nothing, bounded memory cannot hold them exactly.
+     */
+    std::optional<T> quantile(double q) const
+    {
+        if (seen_ == 0 || !(q >= 0.0 && q <= 1.0))
+        {
+            return std::nullopt;
+        }
+
+        const auto rank = static_cast<std::uint64_t>(q * static_cast<double>(seen_ - 1));
+        if (rank >= buffer_.size() || rank >= K)
+        {
+            return std::nullopt;
+        }
+
+        auto values = buffer_;
+        const auto position = static_cast<std::ptrdiff_t>(rank);
+        detail::nth_element(values.data(), values.data() + position, values.data() + values.size(), comp_);
+        return std::move(values[static_cast<std::size_t>(rank)]);
+    }
+
+    /* Number of values top returns, K once the stream has seen that many */
+    std::size_t size() const
+    {
+        return std::min(buffer_.size(), K);
+    }
+
+    /* Number of values pushed so far, including those of merged streams */
+    std::uint64_t seen() const
+    {
+        return seen_;
+    }
+
+    void clear()
+    {
+        buffer_.clear();
+        seen_ = 0;
+        compacted_ = false;
+    }
+
+    private:
+    /* Until the first compaction there is no threshold and every value is a candidate */
+    bool accepts(const T& value)
+    {
+        return !compacted_ || comp_(value, buffer_[K - 1]);
+    }
+
+    template <typename U>
+    void append(U&& value)
+    {
+        buffer_.push_back(std::forward<U>(value));
+        if (buffer_.size() == 2 * K)
+        {
+            compact();
+        }
+    }
+
+    template <typename Iterator>
+    void offer(Iterator current, Iterator end)
+    {
+        for (; current != end && !compacted_; ++current)
+        {
+            append(*current);
+        }
+
+        /* The threshold is read anew for every search, each compaction moves it forward */
+        while (current != end)
+        {
+            current = detail::find_before(current, end, buffer_[K - 1], comp_);
+            if (current == end)
+            {
+                break;
+            }
+            append(*current);
+            ++current;
+        }
+    }
+
+    /* Keeps the best K values, the K-th best of them on the last position becomes the threshold */
+    void compact()
+    {
+        detail::nth_element(buffer_.data(), buffer_.data() + K - 1, buffer_.data() + buffer_.size(), comp_);
+        buffer_.erase(std::next(buffer_.begin(), K), buffer_.end());
+        compacted_ = true;
+    }
+
+    /* Never grows past 2K values, so it is allocated once */
+    std::vector<T> buffer_;
+    [[no_unique_address]] Compare comp_;
+    std::uint64_t seen_ = 0;
+    bool compacted_ = false;
+};
+}  // namespace algorithm
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <ranges>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+#include "argsort.h"
+#include "sort_by_cached_key.h"
+#include "detail/compare.h"
+#include "detail/iterator.h"
+#include "detail/permutation.h"
+#include "detail/type_traits.h"
+
+/*
+ * Sorts parallel arrays (a structure of arrays) together: a range of keys and any number of payload ranges, where
+ * the elements on the same position belong to one record. Only the keys are compared, or read by digits when they are
+ * numbers in natural order. Their stable order is found first and then applied to all the ranges in one walk over the
+ * cycles of the permutation, so no array of structures is built and every element is moved once.
+ */
+namespace algorithm
+{
+namespace detail
+{
+/* Positions of the keys in their stable sorted order */
+template <typename Iterator, typename Compare>
+std::vector<std::size_t> zip_order(Iterator begin, Iterator end, Compare& comp)
+{
+    using value_type = std::iter_value_t<Iterator>;
+
+    std::identity key_of;
+    if constexpr (is_radix_key_v<value_type> && is_natural_order_v<Compare>)
+    {
+        return radix_argsort<8>(begin, end, key_of);
+    }
+    else if constexpr (std::is_copy_constructible_v<value_type>)
+    {
+        /* Copies of the keys are sorted next to their positions, which reads memory sequentially unlike sorting indices */
+        return cached_key_order(begin, end, key_of, comp);
+    }
+    else
+    {
+        return argsort(begin, end, comp);
+    }
+}
+
+/* A payload shorter than the keys would be written past its end, so it is refused before anything moves */
+template <typename Keys, typename... Payloads>
+void check_payload_sizes(Keys& keys, Payloads&... payloads)
+{
+    const auto size = std::distance(std::begin(keys), std::end(keys));
+    if (((std::ranges::distance(payloads) < size) || ...))
+    {
+        throw std::length_error("zip_sort: a payload range holds fewer elements than the keys");
+    }
+}
+
+template <typename Compare, typename Iterator, typename... Payloads>
+void zip_sort(Compare comp, Iterator begin, Iterator end, Payloads... payloads)
+{
+    const auto size = static_cast<std::size_t>(std::distance(begin, end));
+    if (size <= 1)
+    {
+        return;
+    }
+
+    auto order = zip_order(begin, end, comp);
+    auto keys = index_positions(begin, size);
+    std::tuple positions{index_positions(payloads, size)...};
+    std::apply([&](auto&... position) { apply_permutation(order, keys, position...); }, positions);
+}
+}  // namespace detail
+
+/* Stable, every payload range has to hold at least as many elements as the keys, std::length_error is thrown otherwise */
+template <typename Keys, typename... Payloads,
+          typename = std::enable_if_t<detail::is_sortable_v<Keys> && (std::ranges::forward_range<Payloads> && ...)>>
+void zip_sort(Keys& keys, Payloads&... payloads)
+{
+    detail::check_payload_sizes(keys, payloads...);
+    detail::zip_sort(std::less<>{}, detail::unwrap(std::begin(keys)), detail::unwrap(std::end(keys)), detail::unwrap(std::begin(payloads))...);
+}
+
+template <typename Keys, typename Compare, typename... Payloads,
+          typename = std::enable_if_t<detail::is_sortable_by_v<Keys, Compare, std::identity> && (std::ranges::forward_range<Payloads> && ...)>>
+void zip_sort(Keys& keys, Compare comp, Payloads&... payloads)
+{
+    detail::check_payload_sizes(keys, payloads...);
+    detail::zip_sort(comp, detail::unwrap(std::begin(keys)), detail::unwrap(std::end(keys)), detail::unwrap(std::begin(payloads))...);
+}
+}  // namespace algorithm
@@ -1,6 +1,26 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <deque>
+#include <execution>
+#include <forward_list>
 #include <functional>
+#include <list>
+#include <memory>
+#include <memory_resource>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <numeric>
+#include <optional>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <tbb/task_arena.h>
 #include "algorithm/sort/sort.h"
 
 using Range = std::vector<int>;
@@ -8,16 +28,33 @@ using Range = std::vector<int>;
 template <typename T>
 using sort_function = std::function<void(T&)>;
 
+/* Sorts are overloaded for comparators and scratch memory, so they have to be picked by the signature */
+using sort_pointer = void (*)(Range&);
+
 struct sort_fixture : public testing::TestWithParam<sort_function<Range>>
 {
 };
 
 INSTANTIATE_TEST_SUITE_P(sort_fixture, sort_fixture,
-                         testing::Values(algorithm::bubble_sort<Range>,
-                                         algorithm::insertion_sort<Range>,
-                                         algorithm::selection_sort<Range>,
-                                         algorithm::quick_sort<Range>,
-                                         algorithm::merge_sort<Range>));
+                         testing::Values(static_cast<sort_pointer>(algorithm::sort<Range>),
+                                         static_cast<sort_pointer>(algorithm::bubble_sort<Range>),
+                                         static_cast<sort_pointer>(algorithm::insertion_sort<Range>),
+                                         static_cast<sort_pointer>(algorithm::selection_sort<Range>),
+                                         static_cast<sort_pointer>(algorithm::quick_sort<Range>),
+                                         static_cast<sort_pointer>(algorithm::pdq_sort<Range>),
+                                         static_cast<sort_pointer>(algorithm::merge_sort<Range>),
+                                         static_cast<sort_pointer>(algorithm::bottom_up_merge_sort<Range>),
+                                         static_cast<sort_pointer>(algorithm::power_sort<Range>),
+                                         static_cast<sort_pointer>(algorithm::heap_sort<2, Range>),
+                                         static_cast<sort_pointer>(algorithm::heap_sort<4, Range>),
+                                         static_cast<sort_pointer>(algorithm::heap_sort<8, Range>),
+                                         static_cast<sort_pointer>(algorithm::radix_sort<8, true, Range>),
+                                         static_cast<sort_pointer>(algorithm::radix_sort<11, true, Range>),
+                                         static_cast<sort_pointer>(algorithm::radix_sort<16, false, Range>),
+                                         algorithm::parallel_radix_sort<8, true, Range>,
+                                         static_cast<sort_pointer>(algorithm::parallel_sample_sort<Range>),
+                                         static_cast<sort_pointer>(algorithm::counting_sort<Range>),
+                                         static_cast<sort_pointer>(algorithm::bucket_sort<Range>)));
 
 TEST_P(sort_fixture, sort_empty_range)
 {
@@ -99,3 +136,1789 @@ TEST_P(sort_fixture, experiment)
     sorter(many_unsorted_elements);
     EXPECT_THAT(many_unsorted_elements, testing::ElementsAre(1, 2, 3, 4, 5, 6, 7, 8));
 }
+
+TEST(quick_sort, sort_large_sorted_range)
+{
+    Range sorted(100000);
+    std::iota(sorted.begin(), sorted.end(), 0);
+
+    Range expected = sorted;
+    algorithm::quick_sort(sorted);
+    EXPECT_EQ(sorted, expected);
+}
+
+TEST(quick_sort, sort_large_reverse_sorted_range)
+{
+    Range reversed(100000);
+    std::iota(reversed.rbegin(), reversed.rend(), 0);
+
+    Range expected = reversed;
+    std::sort(expected.begin(), expected.end());
+    algorithm::quick_sort(reversed);
+    EXPECT_EQ(reversed, expected);
+}
+
+TEST(quick_sort, sort_large_equal_elements_range)
+{
+    Range equal(100000, 7);
+
+    algorithm::quick_sort(equal);
+    EXPECT_EQ(equal, Range(100000, 7));
+}
+
+TEST(quick_sort, sort_large_random_range)
+{
+    std::mt19937 generator{42};
+    std::uniform_int_distribution<int> distribution{-1000, 1000};
+
+    Range random(100000);
+    std::generate(random.begin(), random.end(), [&] { return distribution(generator); });
+
+    Range expected = random;
+    std::sort(expected.begin(), expected.end());
+    algorithm::quick_sort(random);
+    EXPECT_EQ(random, expected);
+}
+
+TEST(pdq_sort, sort_large_patterned_ranges)
+{
+    const std::size_t size = 100000;
+    std::mt19937 generator{42};
+    std::uniform_int_distribution<int> distribution{-1000, 1000};
+
+    std::vector<Range> patterns(6, Range(size));
+    std::iota(patterns[0].begin(), patterns[0].end(), 0);
+    std::iota(patterns[1].rbegin(), patterns[1].rend(), 0);
+    std::fill(patterns[2].begin(), patterns[2].end(), 7);
+    std::generate(patterns[3].begin(), patterns[3].end(), [&] { return distribution(generator); });
+
+    /* Organ pipe and sawtooth defeat the median of three in a plain quicksort */
+    for (std::size_t index = 0; index < size; ++index)
+    {
+        patterns[4][index] = static_cast<int>(std::min(index, size - index));
+        patterns[5][index] = static_cast<int>(index % 1000);
+    }
+
+    for (auto& pattern : patterns)
+    {
+        Range expected = pattern;
+        std::sort(expected.begin(), expected.end());
+        algorithm::pdq_sort(pattern);
+        EXPECT_EQ(pattern, expected);
+    }
+}
+
+TEST(pdq_sort, sort_nearly_sorted_range)
+{
+    Range nearly_sorted(100000);
+    std::iota(nearly_sorted.begin(), nearly_sorted.end(), 0);
+    std::swap(nearly_sorted[10], nearly_sorted[50000]);
+    std::swap(nearly_sorted[777], nearly_sorted[778]);
+
+    Range expected = nearly_sorted;
+    std::sort(expected.begin(), expected.end());
+    algorithm::pdq_sort(nearly_sorted);
+    EXPECT_EQ(nearly_sorted, expected);
+}
+
+TEST(pdq_sort, sort_non_arithmetic_values)
+{
+    /* Strings are partitioned with branches, lists go to the classic quick sort */
+    std::mt19937 generator{42};
+    std::uniform_int_distribution<int> distribution{0, 500};
+
+    std::vector<std::string> strings(5000);
+    std::generate(strings.begin(), strings.end(), [&] { return std::to_string(distribution(generator)); });
+    std::list<int> list(strings.size());
+    std::generate(list.begin(), list.end(), [&] { return distribution(generator); });
+
+    auto expected_strings = strings;
+    std::sort(expected_strings.begin(), expected_strings.end());
+    algorithm::pdq_sort(strings);
+    EXPECT_EQ(strings, expected_strings);
+
+    auto expected_list = list;
+    expected_list.sort();
+    algorithm::pdq_sort(list);
+    EXPECT_EQ(list, expected_list);
+}
+
+/* Every sort on a copy of the container, against std::sort of the same values */
+template <typename Container>
+void expect_every_sort_sorts(const Container& values)
+{
+    std::vector<int> sorted(values.begin(), values.end());
+    std::sort(sorted.begin(), sorted.end());
+    auto expected = values;
+    std::copy(sorted.begin(), sorted.end(), expected.begin());
+
+    const auto expect_sorts = [&](auto sort)
+    {
+        auto copy = values;
+        sort(copy);
+        EXPECT_EQ(copy, expected);
+    };
+    expect_sorts([](auto& range) { algorithm::bubble_sort(range); });
+    expect_sorts([](auto& range) { algorithm::insertion_sort(range); });
+    expect_sorts([](auto& range) { algorithm::selection_sort(range); });
+    expect_sorts([](auto& range) { algorithm::quick_sort(range); });
+    expect_sorts([](auto& range) { algorithm::pdq_sort(range); });
+    expect_sorts([](auto& range) { algorithm::merge_sort(range); });
+    expect_sorts([](auto& range) { algorithm::bottom_up_merge_sort(range); });
+    expect_sorts([](auto& range) { algorithm::power_sort(range); });
+    expect_sorts([](auto& range) { algorithm::heap_sort(range); });
+    expect_sorts([](auto& range) { algorithm::heap_sort<4>(range); });
+    expect_sorts([](auto& range) { algorithm::radix_sort(range); });
+    expect_sorts([](auto& range) { algorithm::parallel_radix_sort(range); });
+    expect_sorts([](auto& range) { algorithm::counting_sort(range); });
+    expect_sorts([](auto& range) { algorithm::bucket_sort(range); });
+}
+
+TEST(iterator_categories, sort_bidirectional_and_random_access_containers)
+{
+    std::mt19937 generator{42};
+    std::uniform_int_distribution<int> distribution{-500, 500};
+    std::vector<int> values(1500);
+    std::generate(values.begin(), values.end(), [&] { return distribution(generator); });
+
+    /* Lists take the dedicated paths for bidirectional iterators, deques use random access without contiguous storage */
+    expect_every_sort_sorts(std::list<int>(values.begin(), values.end()));
+    expect_every_sort_sorts(std::deque<int>(values.begin(), values.end()));
+    expect_every_sort_sorts(values);
+
+    std::array<int, 100> array;
+    std::copy_n(values.begin(), array.size(), array.begin());
+    expect_every_sort_sorts(array);
+}
+
+/* A lookup table as it would be written by hand, sorted by the given sort during compilation */
+template <typename Sorter>
+constexpr std::array<int, 200> compile_time_table(Sorter sorter)
+{
+    std::array<int, 200> table{};
+    for (int index = 0; index < 200; ++index)
+    {
+        table[index] = (index * 7919 + 13) % 211 - 100;
+    }
+    sorter(table);
+    return table;
+}
+
+TEST(constexpr_sort, sort_tables_at_compile_time)
+{
+    constexpr auto insertion = compile_time_table([](auto& table) { algorithm::insertion_sort(table); });
+    constexpr auto quick = compile_time_table([](auto& table) { algorithm::quick_sort(table); });
+    constexpr auto merge = compile_time_table([](auto& table) { algorithm::merge_sort(table); });
+    constexpr auto heap = compile_time_table([](auto& table) { algorithm::heap_sort(table); });
+    constexpr auto quaternary_heap = compile_time_table([](auto& table) { algorithm::heap_sort<4>(table); });
+
+    static_assert(std::is_sorted(insertion.begin(), insertion.end()));
+    static_assert(quick == insertion && merge == insertion && heap == insertion && quaternary_heap == insertion);
+    static_assert(std::binary_search(quick.begin(), quick.end(), 13 % 211 - 100));
+
+    constexpr auto names = []
+    {
+        std::array<std::string_view, 5> names{"kiwi", "apple", "fig", "banana", "date"};
+        algorithm::merge_sort(names);
+        return names;
+    }();
+    static_assert(names == std::array<std::string_view, 5>{"apple", "banana", "date", "fig", "kiwi"});
+
+    /* Same results at runtime */
+    auto runtime = insertion;
+    std::reverse(runtime.begin(), runtime.end());
+    algorithm::quick_sort(runtime);
+    EXPECT_EQ(runtime, quick);
+}
+
+TEST(heap_sort, sort_large_random_range)
+{
+    std::mt19937 generator{42};
+    std::uniform_int_distribution<int> distribution{-1000, 1000};
+
+    Range random(10007);
+    std::generate(random.begin(), random.end(), [&] { return distribution(generator); });
+
+    Range expected = random;
+    std::sort(expected.begin(), expected.end());
+
+    Range binary = random;
+    algorithm::heap_sort<2>(binary);
+    EXPECT_EQ(binary, expected);
+
+    Range quaternary = random;
+    algorithm::heap_sort<4>(quaternary);
+    EXPECT_EQ(quaternary, expected);
+
+    Range octonary = random;
+    algorithm::heap_sort<8>(octonary);
+    EXPECT_EQ(octonary, expected);
+}
+
+template <typename T>
+struct simd_partition_fixture : public testing::Test
+{
+    /* Few distinct values, so many of them equal the pivot */
+    static std::vector<T> random_values(std::size_t size, int distinct)
+    {
+        std::mt19937 generator{42};
+        std::uniform_int_distribution<int> distribution{-distinct / 2, distinct / 2};
+        std::vector<T> values(size);
+        std::generate(values.begin(), values.end(), [&] { return static_cast<T>(distribution(generator)); });
+        return values;
+    }
+
+    static void expect_partitioned(algorithm::detail::simd_partition_kernel_t<T> kernel)
+    {
+        for (const std::size_t size : {64, 65, 100, 1000, 4099})
+        {
+            for (const int distinct : {1, 10, 1000000})
+            {
+                auto values = random_values(size, distinct);
+                const auto pivot = values.back();
+                auto expected = values;
+                std::sort(expected.begin(), expected.end());
+
+                const auto position = kernel(values.data(), values.data() + values.size());
+                EXPECT_EQ(*position, pivot);
+                EXPECT_TRUE(std::all_of(values.data(), position, [&](T value) { return value < pivot; }));
+                EXPECT_TRUE(std::none_of(position, values.data() + values.size(), [&](T value) { return value < pivot; }));
+
+                std::sort(values.begin(), values.end());
+                EXPECT_EQ(values, expected);
+            }
+        }
+    }
+};
+
+using simd_partition_types = testing::Types<std::int32_t, std::int64_t, float, double>;
+TYPED_TEST_SUITE(simd_partition_fixture, simd_partition_types);
+
+TYPED_TEST(simd_partition_fixture, quick_sort_large_range)
+{
+    auto values = TestFixture::random_values(200000, 5000);
+    auto expected = values;
+    std::sort(expected.begin(), expected.end());
+
+    algorithm::quick_sort(values);
+    EXPECT_EQ(values, expected);
+}
+
+#if ALGORITHM_SORT_SIMD
+TYPED_TEST(simd_partition_fixture, avx2_kernel_partitions)
+{
+    if (!__builtin_cpu_supports("avx2"))
+    {
+        GTEST_SKIP() << "AVX2 is not available";
+    }
+    TestFixture::expect_partitioned(algorithm::detail::avx2_partition<TypeParam>);
+}
+
+TYPED_TEST(simd_partition_fixture, avx512_kernel_partitions)
+{
+    if (!__builtin_cpu_supports("avx512f"))
+    {
+        GTEST_SKIP() << "AVX-512 is not available";
+    }
+    TestFixture::expect_partitioned(algorithm::detail::avx512_partition<TypeParam>);
+}
+#endif
+
+template <typename T, std::size_t N>
+void expect_network_sorts(std::mt19937& generator)
+{
+    std::uniform_int_distribution<int> distribution{-20, 20};
+    for (int repeat = 0; repeat < 100; ++repeat)
+    {
+        std::array<T, N> values;
+        std::generate(values.begin(), values.end(), [&] { return static_cast<T>(distribution(generator)); });
+        auto expected = values;
+        std::sort(expected.begin(), expected.end());
+
+        algorithm::network_sort(values);
+        EXPECT_EQ(values, expected);
+    }
+}
+
+template <typename T, std::size_t... N>
+void expect_networks_sort(std::index_sequence<N...>)
+{
+    std::mt19937 generator{42};
+    (expect_network_sorts<T, N>(generator), ...);
+}
+
+TEST(network_sort, sort_arrays_of_every_size)
+{
+    expect_networks_sort<int>(std::make_index_sequence<33>{});
+    expect_networks_sort<std::int64_t>(std::make_index_sequence<33>{});
+    expect_networks_sort<float>(std::make_index_sequence<33>{});
+    expect_networks_sort<double>(std::make_index_sequence<17>{});
+}
+
+TEST(network_sort, sort_fixed_size_subranges)
+{
+    std::vector<std::string> words{"kiwi", "fig", "apple", "date", "cherry", "banana", "lime", "grape", "pear", "melon"};
+    algorithm::network_sort(std::span<std::string, 6>{words.data(), 6});
+    EXPECT_THAT(words, testing::ElementsAre("apple", "banana", "cherry", "date", "fig", "kiwi", "lime", "grape", "pear", "melon"));
+
+    /* Many tiny groups, each sorted on its own */
+    Range groups{4, 3, 2, 1, 8, 6, 7, 5, 12, 9, 11, 10};
+    for (std::size_t offset = 0; offset < groups.size(); offset += 4)
+    {
+        algorithm::network_sort(std::span<int, 4>{groups.data() + offset, 4});
+    }
+    EXPECT_THAT(groups, testing::ElementsAre(1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12));
+}
+
+#if ALGORITHM_SORT_SIMD
+template <typename T, std::size_t... N>
+void expect_register_networks_sort(std::index_sequence<N...>, bool avx2, bool avx512)
+{
+    std::mt19937 generator{42};
+    std::uniform_int_distribution<int> distribution{-20, 20};
+    const auto expect_sorts = [&](auto size, auto sort)
+    {
+        /* One element more than sorted, which must stay untouched */
+        std::vector<T> values(size + 1);
+        std::generate(values.begin(), values.end(), [&] { return static_cast<T>(distribution(generator)); });
+        auto expected = values;
+        std::sort(expected.begin(), expected.begin() + size);
+
+        sort(values.data());
+        EXPECT_EQ(values, expected);
+    };
+
+    /* One AVX2 register holds eight 32-bit elements, longer size lists only test the AVX-512 networks */
+    if constexpr (sizeof(T) == 4 && ((N <= 8) && ...))
+    {
+        if (avx2)
+        {
+            (expect_sorts(N, algorithm::detail::avx2_network_sort<N, T>), ...);
+        }
+    }
+    if (avx512)
+    {
+        (expect_sorts(N, algorithm::detail::avx512_network_sort<N, T>), ...);
+    }
+}
+
+TEST(network_sort, register_networks_sort)
+{
+    const bool avx2 = __builtin_cpu_supports("avx2");
+    const bool avx512 = __builtin_cpu_supports("avx512f");
+    expect_register_networks_sort<std::int32_t>(std::make_index_sequence<9>{}, avx2, avx512);
+    expect_register_networks_sort<float>(std::make_index_sequence<9>{}, avx2, avx512);
+    expect_register_networks_sort<std::int32_t>(std::index_sequence<9, 12, 15, 16>{}, avx2, avx512);
+    expect_register_networks_sort<std::int64_t>(std::make_index_sequence<9>{}, false, avx512);
+    expect_register_networks_sort<double>(std::make_index_sequence<9>{}, false, avx512);
+}
+#endif
+
+template <typename T>
+struct radix_sort_fixture : public testing::Test
+{
+    static std::vector<T> random_values(std::size_t size)
+    {
+        std::mt19937_64 generator{42};
+        std::vector<T> values(size);
+        if constexpr (std::is_floating_point_v<T>)
+        {
+            std::uniform_real_distribution<T> distribution{-1e6, 1e6};
+            std::generate(values.begin(), values.end(), [&] { return distribution(generator); });
+        }
+        else
+        {
+            using wide_type = std::conditional_t<std::is_signed_v<T>, long long, unsigned long long>;
+            std::uniform_int_distribution<wide_type> distribution{std::numeric_limits<T>::min(), std::numeric_limits<T>::max()};
+            std::generate(values.begin(), values.end(), [&] { return static_cast<T>(distribution(generator)); });
+        }
+        return values;
+    }
+};
+
+using radix_key_types = testing::Types<std::int8_t, std::uint8_t, std::int16_t, std::uint16_t, std::int32_t, std::uint32_t, std::int64_t,
+                                       std::uint64_t, float, double>;
+TYPED_TEST_SUITE(radix_sort_fixture, radix_key_types);
+
+TYPED_TEST(radix_sort_fixture, sort_random_range)
+{
+    auto values = TestFixture::random_values(5000);
+    auto expected = values;
+    std::sort(expected.begin(), expected.end());
+
+    auto byte_digits = values;
+    algorithm::radix_sort<8>(byte_digits);
+    EXPECT_EQ(byte_digits, expected);
+
+    auto eleven_bit_digits = values;
+    algorithm::radix_sort<11>(eleven_bit_digits);
+    EXPECT_EQ(eleven_bit_digits, expected);
+
+    auto two_byte_digits = values;
+    algorithm::radix_sort<16, false>(two_byte_digits);
+    EXPECT_EQ(two_byte_digits, expected);
+}
+
+TYPED_TEST(radix_sort_fixture, sort_extreme_values)
+{
+    using limits = std::numeric_limits<TypeParam>;
+    std::vector<TypeParam> values{limits::max(), TypeParam{0}, limits::lowest(), TypeParam{1}, limits::min(), limits::max()};
+    auto expected = values;
+    std::sort(expected.begin(), expected.end());
+
+    algorithm::radix_sort(values);
+    EXPECT_EQ(values, expected);
+}
+
+TYPED_TEST(radix_sort_fixture, parallel_sort_large_random_range)
+{
+    /* Several chunks, which share output cache lines where their parts of a bucket meet */
+    tbb::task_arena arena{4};
+
+    auto values = TestFixture::random_values(300001);
+    auto expected = values;
+    std::sort(expected.begin(), expected.end());
+
+    arena.execute(
+        [&]
+        {
+            auto byte_digits = values;
+            algorithm::parallel_radix_sort<8>(byte_digits);
+            EXPECT_EQ(byte_digits, expected);
+
+            auto eleven_bit_digits = values;
+            algorithm::parallel_radix_sort<11, false>(eleven_bit_digits);
+            EXPECT_EQ(eleven_bit_digits, expected);
+
+            auto two_byte_digits = values;
+            algorithm::parallel_radix_sort<16>(two_byte_digits);
+            EXPECT_EQ(two_byte_digits, expected);
+        });
+}
+
+TEST(radix_sort, sort_negative_floating_point_values)
+{
+    std::vector<double> values{-0.5, 2.25, -1e300, 0.0, 1e-300, -3.75, 3.75};
+    algorithm::radix_sort(values);
+    EXPECT_THAT(values, testing::ElementsAre(-1e300, -3.75, -0.5, 0.0, 1e-300, 2.25, 3.75));
+}
+
+TEST(counting_sort, sort_small_domain_range)
+{
+    std::mt19937 generator{42};
+    std::uniform_int_distribution<int> distribution{-128, 127};
+
+    std::vector<std::int8_t> values(5000);
+    std::generate(values.begin(), values.end(), [&] { return static_cast<std::int8_t>(distribution(generator)); });
+    auto expected = values;
+    std::sort(expected.begin(), expected.end());
+
+    algorithm::counting_sort(values);
+    EXPECT_EQ(values, expected);
+}
+
+TEST(counting_sort, sort_sparse_range)
+{
+    std::vector<long long> values{1LL << 40, -(1LL << 50), 3, -7, 1LL << 62};
+    algorithm::counting_sort(values);
+    EXPECT_THAT(values, testing::ElementsAre(-(1LL << 50), -7, 3, 1LL << 40, 1LL << 62));
+}
+
+TEST(counting_sort, sort_records_by_key_stably)
+{
+    enum class status : std::uint8_t
+    {
+        ok = 200,
+        not_found = 104,
+        error = 50,
+    };
+    struct record
+    {
+        status code;
+        std::string name;
+    };
+
+    std::list<record> records{{status::ok, "a"}, {status::error, "b"}, {status::not_found, "c"},
+                              {status::ok, "d"}, {status::error, "e"}, {status::ok, "f"}};
+    algorithm::counting_sort(records, [](const record& r) { return r.code; });
+
+    std::vector<std::string> names;
+    std::transform(records.begin(), records.end(), std::back_inserter(names), [](const record& r) { return r.name; });
+    EXPECT_THAT(names, testing::ElementsAre("b", "e", "c", "a", "d", "f"));
+}
+
+TEST(counting_sort, sort_records_by_sparse_key_stably)
+{
+    using record = std::pair<int, int>;
+    std::vector<record> records{{1 << 30, 0}, {-5, 1}, {1 << 30, 2}, {-5, 3}, {0, 4}};
+    algorithm::counting_sort(records, [](const record& r) { return r.first; });
+    EXPECT_THAT(records, testing::ElementsAre(record{-5, 1}, record{-5, 3}, record{0, 4}, record{1 << 30, 0}, record{1 << 30, 2}));
+}
+
+TEST(bucket_sort, sort_uniform_floating_point_range)
+{
+    std::mt19937 generator{42};
+    std::uniform_real_distribution<double> distribution{-1.0, 1.0};
+
+    std::vector<double> values(10000);
+    std::generate(values.begin(), values.end(), [&] { return distribution(generator); });
+    auto expected = values;
+    std::sort(expected.begin(), expected.end());
+
+    algorithm::bucket_sort(values);
+    EXPECT_EQ(values, expected);
+}
+
+TEST(bucket_sort, sort_skewed_floating_point_range)
+{
+    std::mt19937 generator{42};
+    std::exponential_distribution<float> distribution{50.0f};
+
+    std::vector<float> values(10000);
+    std::generate(values.begin(), values.end(), [&] { return distribution(generator); });
+    values.push_back(1e30f);
+    auto expected = values;
+    std::sort(expected.begin(), expected.end());
+
+    algorithm::bucket_sort(values);
+    EXPECT_EQ(values, expected);
+}
+
+TEST(bucket_sort, sort_infinite_and_extreme_values)
+{
+    std::list<double> values{1.0, -std::numeric_limits<double>::infinity(), 0.5, std::numeric_limits<double>::infinity(), -2.0};
+    algorithm::bucket_sort(values);
+    EXPECT_THAT(values, testing::ElementsAre(-std::numeric_limits<double>::infinity(), -2.0, 0.5, 1.0, std::numeric_limits<double>::infinity()));
+
+    std::vector<std::int64_t> integers{std::numeric_limits<std::int64_t>::max(), 0, std::numeric_limits<std::int64_t>::min(), -1, 1};
+    algorithm::bucket_sort(integers);
+    EXPECT_THAT(integers, testing::ElementsAre(std::numeric_limits<std::int64_t>::min(), -1, 0, 1, std::numeric_limits<std::int64_t>::max()));
+}
+
+TEST(bucket_sort, sort_denormal_width_range)
+{
+    /* The buckets per unit of the range overflow to infinity, such ranges are sorted without buckets */
+    const auto smallest = std::numeric_limits<double>::denorm_min();
+    std::vector<double> values{smallest, 0.0, smallest, 0.0};
+    algorithm::bucket_sort(values);
+    EXPECT_THAT(values, testing::ElementsAre(0.0, 0.0, smallest, smallest));
+
+    std::vector<double> denormals(100003);
+    for (std::size_t index = 0; index < denormals.size(); ++index)
+    {
+        denormals[index] = static_cast<double>((index * 7919) % denormals.size()) * smallest;
+    }
+    auto expected = denormals;
+    std::sort(expected.begin(), expected.end());
+
+    auto sorted = denormals;
+    algorithm::bucket_sort(sorted);
+    EXPECT_EQ(sorted, expected);
+
+    tbb::task_arena arena{4};
+    arena.execute([&] { algorithm::bucket_sort(std::execution::par, denormals); });
+    EXPECT_EQ(denormals, expected);
+}
+
+/* Compares by key only, so the order of equal keys shows whether a sort is stable */
+struct keyed_value
+{
+    int key;
+    int order;
+
+    bool operator<(const keyed_value& other) const
+    {
+        return key < other.key;
+    }
+    bool operator>(const keyed_value& other) const
+    {
+        return other < *this;
+    }
+    bool operator==(const keyed_value& other) const = default;
+};
+
+std::vector<keyed_value> random_keyed_values(std::size_t size, int keys)
+{
+    std::mt19937 generator{42};
+    std::uniform_int_distribution<int> distribution{0, keys - 1};
+
+    std::vector<keyed_value> values(size);
+    for (std::size_t index = 0; index < size; ++index)
+    {
+        values[index] = {distribution(generator), static_cast<int>(index)};
+    }
+    return values;
+}
+
+TEST(merge_sort, sort_large_range_stably)
+{
+    auto values = random_keyed_values(10007, 100);
+    auto expected = values;
+    std::stable_sort(expected.begin(), expected.end());
+
+    auto top_down = values;
+    algorithm::merge_sort(top_down);
+    EXPECT_EQ(top_down, expected);
+
+    auto bottom_up = values;
+    algorithm::bottom_up_merge_sort(bottom_up);
+    EXPECT_EQ(bottom_up, expected);
+
+    std::list<keyed_value> list{values.begin(), values.end()};
+    algorithm::bottom_up_merge_sort(list);
+    EXPECT_TRUE(std::equal(list.begin(), list.end(), expected.begin(), expected.end()));
+}
+
+TEST(merge_sort, sort_large_range_stably_on_several_threads)
+{
+    /* Four threads even on a single core, so the halves become tasks and the merges are split by merge path */
+    tbb::task_arena arena{4};
+
+    auto values = random_keyed_values(200003, 100);
+    auto expected = values;
+    std::stable_sort(expected.begin(), expected.end());
+    arena.execute([&] { algorithm::merge_sort(std::execution::par, values); });
+    EXPECT_EQ(values, expected);
+
+    /* Halves of very different values put the merge path cuts at the ends of the runs */
+    std::deque<keyed_value> halves(expected.rbegin(), expected.rend());
+    std::rotate(halves.begin(), halves.begin() + 70001, halves.end());
+    auto expected_halves = std::vector<keyed_value>(halves.begin(), halves.end());
+    std::stable_sort(expected_halves.begin(), expected_halves.end(), std::greater<>{});
+    arena.execute([&] { algorithm::merge_sort(std::execution::par, halves, std::greater<>{}); });
+    EXPECT_TRUE(std::equal(halves.begin(), halves.end(), expected_halves.begin(), expected_halves.end()));
+
+    std::vector<std::string> words(50000);
+    std::generate(words.begin(), words.end(), [index = 0]() mutable { return std::to_string(index++ * 7919 % 50000); });
+    auto expected_words = words;
+    std::sort(expected_words.begin(), expected_words.end());
+    arena.execute([&] { algorithm::merge_sort(std::execution::par_unseq, words); });
+    EXPECT_EQ(words, expected_words);
+
+    /* Without a parallel policy the comparator is only ever called on the calling thread */
+    std::atomic<bool> called_elsewhere{false};
+    auto unshuffled = random_keyed_values(200003, 100);
+    arena.execute(
+        [&]
+        {
+            const auto caller = std::this_thread::get_id();
+            const auto on_caller = [&](const keyed_value& lhs, const keyed_value& rhs)
+            {
+                called_elsewhere = called_elsewhere || std::this_thread::get_id() != caller;
+                return lhs < rhs;
+            };
+            algorithm::merge_sort(unshuffled, on_caller);
+        });
+    EXPECT_FALSE(called_elsewhere);
+    EXPECT_EQ(unshuffled, expected);
+}
+
+TEST(list_sort, sort_lists_stably)
+{
+    auto values = random_keyed_values(10007, 100);
+    auto expected = values;
+    std::stable_sort(expected.begin(), expected.end());
+
+    std::list<keyed_value> list{values.begin(), values.end()};
+    algorithm::list_sort(list);
+    EXPECT_TRUE(std::equal(list.begin(), list.end(), expected.begin(), expected.end()));
+
+    std::forward_list<keyed_value> forward_list{values.begin(), values.end()};
+    algorithm::list_sort(forward_list);
+    EXPECT_TRUE(std::equal(forward_list.begin(), forward_list.end(), expected.begin(), expected.end()));
+
+    /* merge_sort hands lists over to list_sort */
+    std::list<keyed_value> merged{values.begin(), values.end()};
+    algorithm::merge_sort(merged);
+    EXPECT_TRUE(std::equal(merged.begin(), merged.end(), expected.begin(), expected.end()));
+}
+
+/* Can be neither copied nor moved, so only relinking the nodes can sort it */
+struct pinned_value
+{
+    explicit pinned_value(int value) : value(value) {}
+    pinned_value(const pinned_value&) = delete;
+    pinned_value& operator=(const pinned_value&) = delete;
+
+    bool operator<(const pinned_value& other) const
+    {
+        return value < other.value;
+    }
+
+    int value;
+};
+
+TEST(list_sort, sort_by_relinking_nodes)
+{
+    std::list<pinned_value> list;
+    std::vector<const pinned_value*> addresses;
+    for (const int value : {5, 3, 9, 1, 7, 3, 8, 2})
+    {
+        addresses.push_back(&list.emplace_back(value));
+    }
+
+    algorithm::list_sort(list);
+
+    std::vector<int> sorted;
+    for (const auto& element : list)
+    {
+        sorted.push_back(element.value);
+    }
+    EXPECT_THAT(sorted, testing::ElementsAre(1, 2, 3, 3, 5, 7, 8, 9));
+
+    /* Nodes stay where they were, only the links changed */
+    EXPECT_EQ(&*std::next(list.begin()), addresses[7]);
+    EXPECT_EQ(&list.back(), addresses[2]);
+}
+
+TEST(list_sort, hand_lists_over_from_other_sorts)
+{
+    const auto values = random_keyed_values(5003, 100);
+    auto expected = values;
+    std::stable_sort(expected.begin(), expected.end());
+
+    /* Every value has to stay in its node, so the nodes were relinked and not stepped through and moved */
+    const auto expect_relinked = [&](const std::function<void(std::list<keyed_value>&)>& sorter)
+    {
+        std::list<keyed_value> list{values.begin(), values.end()};
+        std::vector<std::pair<const keyed_value*, keyed_value>> nodes;
+        for (const auto& value : list)
+        {
+            nodes.emplace_back(&value, value);
+        }
+
+        sorter(list);
+        EXPECT_TRUE(std::equal(list.begin(), list.end(), expected.begin(), expected.end()));
+        EXPECT_TRUE(std::all_of(nodes.begin(), nodes.end(), [](const auto& node) { return *node.first == node.second; }));
+    };
+
+    std::array<std::byte, 64> scratch{};
+    expect_relinked([](auto& list) { algorithm::quick_sort(list); });
+    expect_relinked([](auto& list) { algorithm::quick_sort(std::execution::par, list, std::less<>{}); });
+    expect_relinked([](auto& list) { algorithm::pdq_sort(list); });
+    expect_relinked([](auto& list) { algorithm::merge_sort(std::execution::par, list); });
+    expect_relinked([&](auto& list) { algorithm::merge_sort(list, std::span{scratch}); });
+    expect_relinked([](auto& list) { algorithm::bottom_up_merge_sort(list, std::less<>{}); });
+    expect_relinked([](auto& list) { algorithm::parallel_sample_sort(list); });
+}
+
+TEST(comparator, sort_by_comparator_and_projection)
+{
+    const auto values = random_keyed_values(3000, 50);
+    auto expected = values;
+    std::stable_sort(expected.begin(), expected.end(), [](const auto& lhs, const auto& rhs) { return lhs.key > rhs.key; });
+
+    const auto keys_of = [](const auto& range)
+    {
+        std::vector<int> keys;
+        std::transform(range.begin(), range.end(), std::back_inserter(keys), [](const keyed_value& value) { return value.key; });
+        return keys;
+    };
+    const auto expect_sorted = [&](const std::function<void(std::vector<keyed_value>&)>& sorter, bool stable)
+    {
+        auto sorted = values;
+        sorter(sorted);
+        if (stable)
+        {
+            EXPECT_EQ(sorted, expected);
+        }
+        else
+        {
+            EXPECT_EQ(keys_of(sorted), keys_of(expected));
+        }
+    };
+
+    const std::greater<> descending;
+    expect_sorted([&](auto& range) { algorithm::bubble_sort(range, descending, &keyed_value::key); }, false);
+    expect_sorted([&](auto& range) { algorithm::insertion_sort(range, descending, &keyed_value::key); }, true);
+    expect_sorted([&](auto& range) { algorithm::selection_sort(range, descending, &keyed_value::key); }, false);
+    expect_sorted([&](auto& range) { algorithm::quick_sort(range, descending, &keyed_value::key); }, false);
+    expect_sorted([&](auto& range) { algorithm::pdq_sort(range, descending, &keyed_value::key); }, false);
+    expect_sorted([&](auto& range) { algorithm::merge_sort(range, descending, &keyed_value::key); }, true);
+    expect_sorted([&](auto& range) { algorithm::bottom_up_merge_sort(range, descending, &keyed_value::key); }, true);
+    expect_sorted([&](auto& range) { algorithm::power_sort(range, descending, &keyed_value::key); }, true);
+    expect_sorted([&](auto& range) { algorithm::heap_sort(range, descending, &keyed_value::key); }, false);
+    expect_sorted([&](auto& range) { algorithm::heap_sort<4>(range, descending, &keyed_value::key); }, false);
+    expect_sorted([&](auto& range) { algorithm::parallel_sample_sort(range, descending, &keyed_value::key); }, false);
+
+    /* Comparators without a projection */
+    expect_sorted([](auto& range) { algorithm::power_sort(range, std::greater<>{}); }, true);
+    expect_sorted([](auto& range) { algorithm::quick_sort(range, [](const auto& lhs, const auto& rhs) { return lhs.key > rhs.key; }); }, false);
+
+    std::list<keyed_value> list{values.begin(), values.end()};
+    algorithm::merge_sort(list, descending, &keyed_value::key);
+    EXPECT_TRUE(std::equal(list.begin(), list.end(), expected.begin(), expected.end()));
+
+    std::forward_list<keyed_value> forward_list{values.begin(), values.end()};
+    algorithm::list_sort(forward_list, descending, &keyed_value::key);
+    EXPECT_TRUE(std::equal(forward_list.begin(), forward_list.end(), expected.begin(), expected.end()));
+}
+
+TEST(comparator, sort_numbers_in_reverse_order)
+{
+    /* Numbers in natural order take the vectorized partition and the register networks, other orders must not */
+    std::mt19937 generator{42};
+    std::uniform_int_distribution<int> distribution{-1000, 1000};
+    std::vector<int> values(10000);
+    std::generate(values.begin(), values.end(), [&] { return distribution(generator); });
+
+    for (const auto& sorter : std::vector<std::function<void(std::vector<int>&)>>{
+             [](auto& range) { algorithm::quick_sort(range, std::greater<>{}); }, [](auto& range) { algorithm::pdq_sort(range, std::greater<>{}); },
+             [](auto& range) { algorithm::merge_sort(range, std::ranges::greater{}); },
+             [](auto& range) { algorithm::quick_sort(range, std::less<>{}, std::negate<>{}); }})
+    {
+        auto sorted = values;
+        sorter(sorted);
+        EXPECT_TRUE(std::is_sorted(sorted.begin(), sorted.end(), std::greater<>{}));
+    }
+
+    std::array<float, 7> array{3.0f, -1.0f, 7.5f, 0.0f, 2.0f, -4.0f, 1.0f};
+    algorithm::network_sort(array, std::greater<>{});
+    EXPECT_THAT(array, testing::ElementsAre(7.5f, 3.0f, 2.0f, 1.0f, 0.0f, -1.0f, -4.0f));
+}
+
+TEST(sort_by_cached_key, compute_every_key_once)
+{
+    const std::vector<std::string> words{"pear", "Apple", "fig", "apple", "Banana", "PEAR", "cherry", "banana", "Fig", "date"};
+
+    std::size_t computed = 0;
+    const auto lowercase = [&computed](const std::string& word)
+    {
+        ++computed;
+        std::string key = word;
+        std::transform(key.begin(), key.end(), key.begin(), [](unsigned char letter) { return static_cast<char>(std::tolower(letter)); });
+        return key;
+    };
+
+    auto sorted = words;
+    algorithm::sort_by_cached_key(sorted, lowercase);
+    EXPECT_EQ(computed, words.size());
+    EXPECT_THAT(sorted, testing::ElementsAre("Apple", "apple", "Banana", "banana", "cherry", "date", "fig", "Fig", "pear", "PEAR"));
+
+    computed = 0;
+    std::list<std::string> list{words.begin(), words.end()};
+    algorithm::sort_by_cached_key(list, lowercase, std::greater<>{});
+    EXPECT_EQ(computed, words.size());
+    EXPECT_THAT(list, testing::ElementsAre("pear", "PEAR", "fig", "Fig", "date", "cherry", "Banana", "banana", "Apple", "apple"));
+}
+
+TEST(sort_by_cached_key, sort_large_range_stably)
+{
+    auto values = random_keyed_values(10007, 100);
+    auto expected = values;
+    std::stable_sort(expected.begin(), expected.end());
+
+    algorithm::sort_by_cached_key(values, &keyed_value::key);
+    EXPECT_EQ(values, expected);
+}
+
+/* Large record, moving it costs much more than comparing the score */
+struct record
+{
+    double score;
+    int id;
+    std::array<char, 188> payload;
+};
+
+TEST(argsort, sort_indices_stably)
+{
+    const auto values = random_keyed_values(20011, 100);
+    auto expected = values;
+    std::stable_sort(expected.begin(), expected.end());
+
+    const auto expect_order = [&](const std::vector<std::size_t>& order)
+    {
+        ASSERT_EQ(order.size(), values.size());
+        for (std::size_t index = 0; index < order.size(); ++index)
+        {
+            EXPECT_EQ(values[order[index]], expected[index]);
+        }
+    };
+
+    expect_order(algorithm::argsort(values));
+    expect_order(algorithm::parallel_argsort(values));
+    expect_order(algorithm::radix_argsort(values, &keyed_value::key));
+    expect_order(algorithm::radix_argsort<16>(values, &keyed_value::key));
+
+    const std::list<keyed_value> list{values.begin(), values.end()};
+    expect_order(algorithm::argsort(list));
+
+    EXPECT_THAT(algorithm::argsort(std::vector<int>{}), testing::IsEmpty());
+    EXPECT_THAT(algorithm::argsort(std::vector<int>{3, 1, 2}, std::greater<>{}), testing::ElementsAre(0, 2, 1));
+    EXPECT_THAT(algorithm::radix_argsort(std::vector<double>{0.5, -2.0, 1e10, -1e-3}), testing::ElementsAre(1, 3, 0, 2));
+}
+
+TEST(argsort, apply_permutation_to_several_ranges)
+{
+    std::mt19937 generator{42};
+    std::uniform_real_distribution<double> distribution{-1.0, 1.0};
+
+    std::vector<record> records(5000);
+    std::vector<std::string> names(records.size());
+    std::list<int> ids;
+    for (std::size_t index = 0; index < records.size(); ++index)
+    {
+        records[index].score = distribution(generator);
+        records[index].id = static_cast<int>(index);
+        names[index] = std::to_string(index);
+        ids.push_back(static_cast<int>(index));
+    }
+
+    const auto order = algorithm::argsort(records, std::less<>{}, &record::score);
+    algorithm::apply_permutation(order, records, names, ids);
+
+    EXPECT_TRUE(std::is_sorted(records.begin(), records.end(), [](const auto& lhs, const auto& rhs) { return lhs.score < rhs.score; }));
+    auto id = ids.begin();
+    for (std::size_t index = 0; index < records.size(); ++index, ++id)
+    {
+        EXPECT_EQ(records[index].id, static_cast<int>(order[index]));
+        EXPECT_EQ(names[index], std::to_string(order[index]));
+        EXPECT_EQ(*id, static_cast<int>(order[index]));
+    }
+}
+
+/* Counts its copies, sorts are expected to only ever move the elements */
+struct copy_counted
+{
+    explicit copy_counted(int value) : value(value) {}
+    copy_counted(const copy_counted& other) : value(other.value)
+    {
+        ++copies;
+    }
+    copy_counted(copy_counted&&) noexcept = default;
+    copy_counted& operator=(const copy_counted& other)
+    {
+        value = other.value;
+        ++copies;
+        return *this;
+    }
+    copy_counted& operator=(copy_counted&&) noexcept = default;
+
+    bool operator<(const copy_counted& other) const
+    {
+        return value < other.value;
+    }
+
+    int value;
+    static inline int copies = 0;
+};
+
+struct move_only_value
+{
+    explicit move_only_value(int value) : value(std::make_unique<int>(value)) {}
+
+    bool operator<(const move_only_value& other) const
+    {
+        return *value < *other.value;
+    }
+
+    std::unique_ptr<int> value;
+};
+
+template <typename Container>
+void expect_sorted_by_moves(const std::vector<int>& values, const std::function<void(Container&)>& sort)
+{
+    Container container;
+    for (const int value : values)
+    {
+        container.emplace_back(value);
+    }
+
+    copy_counted::copies = 0;
+    sort(container);
+    EXPECT_EQ(copy_counted::copies, 0);
+
+    std::vector<int> sorted;
+    for (const auto& element : container)
+    {
+        if constexpr (std::is_same_v<typename Container::value_type, move_only_value>)
+        {
+            sorted.push_back(*element.value);
+        }
+        else
+        {
+            sorted.push_back(element.value);
+        }
+    }
+    EXPECT_TRUE(std::is_sorted(sorted.begin(), sorted.end()));
+}
+
+template <typename Container>
+void expect_every_sort_moves(const std::vector<int>& values)
+{
+    expect_sorted_by_moves<Container>(values, [](auto& range) { algorithm::bubble_sort(range); });
+    expect_sorted_by_moves<Container>(values, [](auto& range) { algorithm::insertion_sort(range); });
+    expect_sorted_by_moves<Container>(values, [](auto& range) { algorithm::selection_sort(range); });
+    expect_sorted_by_moves<Container>(values, [](auto& range) { algorithm::quick_sort(range); });
+    expect_sorted_by_moves<Container>(values, [](auto& range) { algorithm::pdq_sort(range); });
+    expect_sorted_by_moves<Container>(values, [](auto& range) { algorithm::merge_sort(range); });
+    expect_sorted_by_moves<Container>(values, [](auto& range) { algorithm::bottom_up_merge_sort(range); });
+    expect_sorted_by_moves<Container>(values, [](auto& range) { algorithm::power_sort(range); });
+    expect_sorted_by_moves<Container>(values, [](auto& range) { algorithm::heap_sort(range); });
+    expect_sorted_by_moves<Container>(values, [](auto& range) { algorithm::heap_sort<4>(range); });
+
+    /* Short ranges take the sorting networks */
+    expect_sorted_by_moves<Container>({3, 1, 2, 5, 4}, [](auto& range) { algorithm::quick_sort(range); });
+}
+
+TEST(move_only, sort_by_moves_only)
+{
+    std::mt19937 generator{42};
+    std::uniform_int_distribution<int> distribution{0, 100};
+    std::vector<int> values(2000);
+    std::generate(values.begin(), values.end(), [&] { return distribution(generator); });
+
+    expect_every_sort_moves<std::vector<copy_counted>>(values);
+    expect_every_sort_moves<std::vector<move_only_value>>(values);
+    expect_every_sort_moves<std::list<copy_counted>>(values);
+    expect_every_sort_moves<std::list<move_only_value>>(values);
+
+    /* Stable counting by a key and networks over a fixed size piece */
+    const auto key_of = [](const move_only_value& element) { return *element.value; };
+    expect_sorted_by_moves<std::vector<move_only_value>>(values, [&](auto& range) { algorithm::counting_sort(range, key_of); });
+    expect_sorted_by_moves<std::vector<copy_counted>>(
+        {values.begin(), values.begin() + 16}, [](auto& range) { algorithm::network_sort(std::span<copy_counted, 16>{range.data(), 16}); });
+}
+
+/* Fails every allocation above the given number of bytes, so sorts have to get by with what they got */
+struct limited_resource : public std::pmr::memory_resource
+{
+    explicit limited_resource(std::size_t limit) : limit(limit) {}
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        if (allocated + bytes > limit)
+        {
+            throw std::bad_alloc{};
+        }
+        allocated += bytes;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* pointer, std::size_t bytes, std::size_t alignment) override
+    {
+        allocated -= bytes;
+        std::pmr::new_delete_resource()->deallocate(pointer, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+
+    std::size_t limit;
+    std::size_t allocated = 0;
+};
+
+TEST(zip_sort, sort_columns_by_keys)
+{
+    std::mt19937 generator{42};
+    std::uniform_int_distribution<int> distribution{-50, 50};
+
+    /* Column store: keys and payloads of the same row share the position */
+    std::vector<int> keys(10007);
+    std::generate(keys.begin(), keys.end(), [&] { return distribution(generator); });
+    std::vector<std::size_t> rows(keys.size());
+    std::iota(rows.begin(), rows.end(), std::size_t{0});
+    std::vector<std::string> names(keys.size());
+    std::transform(rows.begin(), rows.end(), names.begin(), [](std::size_t row) { return std::to_string(row); });
+    std::deque<double> values(keys.begin(), keys.end());
+
+    const auto original = keys;
+    algorithm::zip_sort(keys, rows, names, values);
+
+    EXPECT_TRUE(std::is_sorted(keys.begin(), keys.end()));
+    for (std::size_t index = 0; index < keys.size(); ++index)
+    {
+        EXPECT_EQ(keys[index], original[rows[index]]);
+        EXPECT_EQ(names[index], std::to_string(rows[index]));
+        EXPECT_EQ(values[index], keys[index]);
+    }
+
+    /* Equal keys keep the order of their rows */
+    for (std::size_t index = 1; index < keys.size(); ++index)
+    {
+        if (keys[index - 1] == keys[index])
+        {
+            EXPECT_LT(rows[index - 1], rows[index]);
+        }
+    }
+}
+
+TEST(zip_sort, sort_columns_by_comparator)
+{
+    std::vector<std::string> keys{"pear", "apple", "fig", "banana", "apple"};
+    std::list<int> prices{4, 1, 3, 2, 5};
+    std::vector<std::unique_ptr<int>> handles;
+    for (int handle = 0; handle < 5; ++handle)
+    {
+        handles.push_back(std::make_unique<int>(handle));
+    }
+
+    algorithm::zip_sort(keys, std::greater<>{}, prices, handles);
+    EXPECT_THAT(keys, testing::ElementsAre("pear", "fig", "banana", "apple", "apple"));
+    EXPECT_THAT(prices, testing::ElementsAre(4, 3, 2, 1, 5));
+    EXPECT_EQ(*handles.front(), 0);
+    EXPECT_EQ(*handles.back(), 4);
+
+    /* Keys alone and move-only keys */
+    std::vector<move_only_value> unique_keys;
+    for (const int key : {3, 1, 2})
+    {
+        unique_keys.emplace_back(key);
+    }
+    std::vector<char> labels{'c', 'a', 'b'};
+    algorithm::zip_sort(unique_keys, labels);
+    EXPECT_THAT(labels, testing::ElementsAre('a', 'b', 'c'));
+
+    /* A payload shorter than the keys is refused and nothing moves, longer payloads keep their extra elements */
+    std::vector<int> short_payload{1, 2};
+    EXPECT_THROW(algorithm::zip_sort(keys, std::less<>{}, prices, short_payload), std::length_error);
+    EXPECT_THAT(keys, testing::ElementsAre("pear", "fig", "banana", "apple", "apple"));
+    std::vector<int> long_payload{5, 4, 3, 2, 1, 0};
+    algorithm::zip_sort(keys, long_payload);
+    EXPECT_THAT(long_payload, testing::ElementsAre(2, 1, 3, 4, 5, 0));
+}
+
+TEST(parallel_sample_sort, sort_large_ranges_on_several_threads)
+{
+    /* Four threads even on a single core, so the ranges are split into stripes */
+    tbb::task_arena arena{4};
+    std::mt19937 generator{42};
+
+    /* Sizes off the block boundaries, wide and narrow value domains, presorted inputs */
+    for (const std::size_t size : {100000u, 262144u, 300007u})
+    {
+        for (const int domain : {std::numeric_limits<int>::max(), 1000, 3, 1})
+        {
+            std::uniform_int_distribution<int> distribution{0, domain - 1};
+            std::vector<int> values(size);
+            std::generate(values.begin(), values.end(), [&] { return distribution(generator); });
+
+            auto expected = values;
+            std::sort(expected.begin(), expected.end());
+            arena.execute([&] { algorithm::parallel_sample_sort(values); });
+            EXPECT_EQ(values, expected);
+
+            arena.execute([&] { algorithm::parallel_sample_sort(values, std::greater<>{}); });
+            EXPECT_TRUE(std::is_sorted(values.begin(), values.end(), std::greater<>{}));
+        }
+    }
+
+    /* Elements which are not trivially moved, with a block of only a few elements */
+    std::vector<std::string> words(120001);
+    std::uniform_int_distribution<int> letter{'a', 'z'};
+    for (auto& word : words)
+    {
+        word = std::string(24, 'a');
+        std::generate(word.begin(), word.end(), [&] { return static_cast<char>(letter(generator)); });
+    }
+    auto expected = words;
+    std::sort(expected.begin(), expected.end());
+    arena.execute([&] { algorithm::parallel_sample_sort(words); });
+    EXPECT_EQ(words, expected);
+
+    /* Every record is still there once they are put back in their original order */
+    const auto original = random_keyed_values(200000, 5000);
+    auto records = original;
+    arena.execute([&] { algorithm::parallel_sample_sort(records, std::less<>{}, &keyed_value::key); });
+    EXPECT_TRUE(std::is_sorted(records.begin(), records.end()));
+    std::sort(records.begin(), records.end(), [](const auto& lhs, const auto& rhs) { return lhs.order < rhs.order; });
+    EXPECT_EQ(records, original);
+}
+
+/* Quadratic sorts get ranges just long enough for their parallel paths, the others ranges long enough for several tasks */
+template <typename ExecutionPolicy>
+void sort_under_policy(const ExecutionPolicy& policy)
+{
+    constexpr bool parallel = !std::is_same_v<ExecutionPolicy, std::execution::sequenced_policy> &&
+                              !std::is_same_v<ExecutionPolicy, std::execution::unsequenced_policy>;
+    const std::size_t quadratic_size = parallel ? 9001 : 2003;
+    std::mt19937 generator{42};
+    const auto random_values = [&](std::size_t size, int domain)
+    {
+        std::uniform_int_distribution<int> distribution{-domain, domain};
+        std::vector<int> values(size);
+        std::generate(values.begin(), values.end(), [&] { return distribution(generator); });
+        return values;
+    };
+    const auto expect_sorted = [&](std::size_t size, int domain, auto sort)
+    {
+        auto values = random_values(size, domain);
+        auto expected = values;
+        std::sort(expected.begin(), expected.end());
+        sort(values);
+        EXPECT_EQ(values, expected);
+    };
+
+    expect_sorted(quadratic_size, 1000000, [&](auto& values) { algorithm::bubble_sort(policy, values); });
+    expect_sorted(quadratic_size, 1000000, [&](auto& values) { algorithm::selection_sort(policy, values); });
+    expect_sorted(quadratic_size, 1000000, [&](auto& values) { algorithm::insertion_sort(policy, values); });
+    for (const int domain : {1000000, 10})
+    {
+        expect_sorted(100003, domain, [&](auto& values) { algorithm::quick_sort(policy, values); });
+        expect_sorted(100003, domain, [&](auto& values) { algorithm::merge_sort(policy, values); });
+        expect_sorted(100003, domain, [&](auto& values) { algorithm::heap_sort(policy, values); });
+        expect_sorted(100003, domain, [&](auto& values) { algorithm::heap_sort<4>(policy, values); });
+        expect_sorted(100003, domain, [&](auto& values) { algorithm::radix_sort(policy, values); });
+        expect_sorted(100003, domain, [&](auto& values) { algorithm::counting_sort(policy, values); });
+        expect_sorted(100003, domain, [&](auto& values) { algorithm::bucket_sort(policy, values); });
+    }
+
+    /*
+     * Sparse keys make the counting sort fall back to the radix sort, and so do keys too wide for a histogram per thread.
+     * Infinite bounds make the bucket sort fall back to quick sort.
+     */
+    expect_sorted(100000, std::numeric_limits<int>::max(), [&](auto& values) { algorithm::counting_sort(policy, values); });
+    expect_sorted(100000, 60000, [&](auto& values) { algorithm::counting_sort(policy, values); });
+    std::vector<double> reals(100000);
+    std::uniform_real_distribution<double> real_distribution{-1.0, 1.0};
+    std::generate(reals.begin(), reals.end(), [&] { return real_distribution(generator); });
+    reals[10] = std::numeric_limits<double>::infinity();
+    auto expected_reals = reals;
+    std::sort(expected_reals.begin(), expected_reals.end());
+    algorithm::bucket_sort(policy, reals);
+    EXPECT_EQ(reals, expected_reals);
+
+    /* Comparison sorts take comparators and projections, and the stable ones keep equal keys in order */
+    const auto records = random_keyed_values(quadratic_size, 100);
+    auto expected = records;
+    std::stable_sort(expected.begin(), expected.end(), [](const auto& lhs, const auto& rhs) { return lhs.key > rhs.key; });
+    for (const auto& sort : std::vector<std::function<void(std::vector<keyed_value>&)>>{
+             [&](auto& values) { algorithm::insertion_sort(policy, values, std::greater<>{}, &keyed_value::key); },
+             [&](auto& values) { algorithm::merge_sort(policy, values, std::greater<>{}, &keyed_value::key); }})
+    {
+        auto values = records;
+        sort(values);
+        EXPECT_EQ(values, expected);
+    }
+
+    auto words = std::vector<std::string>{"pear", "fig", "apple", "kiwi", "plum", "date", "lime", "grape", "melon"};
+    auto expected_words = words;
+    std::sort(expected_words.begin(), expected_words.end(), std::greater<>{});
+    for (const auto& sort : std::vector<std::function<void(std::vector<std::string>&)>>{
+             [&](auto& values) { algorithm::bubble_sort(policy, values, std::greater<>{}); },
+             [&](auto& values) { algorithm::selection_sort(policy, values, std::greater<>{}); },
+             [&](auto& values) { algorithm::quick_sort(policy, values, std::greater<>{}); },
+             [&](auto& values) { algorithm::heap_sort(policy, values, std::greater<>{}); }})
+    {
+        auto values = words;
+        sort(values);
+        EXPECT_EQ(values, expected_words);
+    }
+
+    std::list<int> list{5, 3, 9, 1, 7, 3};
+    algorithm::bubble_sort(policy, list);
+    EXPECT_THAT(list, testing::ElementsAre(1, 3, 3, 5, 7, 9));
+}
+
+TEST(execution_policy, sort_under_every_policy)
+{
+    /* Four threads even on a single core, so the parallel policies really split the work */
+    tbb::task_arena arena{4};
+    arena.execute(
+        []
+        {
+            sort_under_policy(std::execution::seq);
+            sort_under_policy(std::execution::unseq);
+            sort_under_policy(std::execution::par);
+            sort_under_policy(std::execution::par_unseq);
+        });
+}
+
+template <typename T, typename Compare = std::less<>>
+algorithm::detail::sort_engine engine_for(std::vector<T> values, Compare comp = {}, const algorithm::sort_thresholds& thresholds = {})
+{
+    return algorithm::detail::choose_sort_engine(values.begin(), values.end(), thresholds, comp);
+}
+
+TEST(adaptive_sort, route_by_type_size_and_presortedness)
+{
+    using algorithm::detail::sort_engine;
+    std::mt19937 generator{42};
+    const auto random_values = [&](std::size_t size, int domain)
+    {
+        std::uniform_int_distribution<int> distribution{0, domain - 1};
+        std::vector<int> values(size);
+        std::generate(values.begin(), values.end(), [&] { return distribution(generator); });
+        return values;
+    };
+
+    EXPECT_EQ(engine_for(random_values(20, 1000)), sort_engine::network);
+    EXPECT_EQ(engine_for(std::vector<std::string>{"b", "c", "a"}), sort_engine::insertion);
+    EXPECT_EQ(engine_for(random_values(100, 1000000)), sort_engine::introsort);
+    EXPECT_EQ(engine_for(random_values(10000, 1000000)), sort_engine::radix);
+    EXPECT_EQ(engine_for(random_values(10000, 100)), sort_engine::counting);
+    EXPECT_EQ(engine_for(random_values(2000000, std::numeric_limits<int>::max())), sort_engine::introsort);
+
+    /* Few long runs, and few out of order pairs even when they cut the range into many short runs */
+    auto sorted = random_values(10000, 1000000);
+    std::sort(sorted.begin(), sorted.end());
+    EXPECT_EQ(engine_for(sorted), sort_engine::adaptive_merge);
+    EXPECT_EQ(engine_for(std::vector<int>(sorted.rbegin(), sorted.rend())), sort_engine::adaptive_merge);
+    auto nearly_sorted = sorted;
+    for (std::size_t index = 0; index + 1 < nearly_sorted.size(); index += 16)
+    {
+        std::swap(nearly_sorted[index], nearly_sorted[index + 1]);
+    }
+    EXPECT_EQ(engine_for(nearly_sorted), sort_engine::adaptive_merge);
+
+    /* Digits are not read for other orders, and the table moves the boundaries */
+    std::vector<double> reals(10000);
+    std::uniform_real_distribution<double> real_distribution{-1.0, 1.0};
+    std::generate(reals.begin(), reals.end(), [&] { return real_distribution(generator); });
+    EXPECT_EQ(engine_for(reals), sort_engine::radix);
+    EXPECT_EQ(engine_for(reals, std::greater<>{}), sort_engine::introsort);
+    reals[reals.size() / 2] = std::numeric_limits<double>::quiet_NaN();
+    EXPECT_EQ(engine_for(reals), sort_engine::introsort);
+    EXPECT_EQ(engine_for(random_values(10000, 1000000), std::less<>{}, {.radix = 100000}), sort_engine::introsort);
+    EXPECT_EQ(engine_for(random_values(50, 1000000), std::less<>{}, {.network = 8, .insertion = 64}), sort_engine::insertion);
+}
+
+TEST(adaptive_sort, sort_with_every_engine)
+{
+    std::mt19937 generator{42};
+    for (const std::size_t size : {0u, 1u, 7u, 32u, 100u, 1000u, 100000u})
+    {
+        for (const int domain : {std::numeric_limits<int>::max(), 1000, 2})
+        {
+            std::uniform_int_distribution<int> distribution{-domain / 2, domain / 2};
+            std::vector<int> values(size);
+            std::generate(values.begin(), values.end(), [&] { return distribution(generator); });
+            auto expected = values;
+            std::sort(expected.begin(), expected.end());
+
+            auto sorted = values;
+            algorithm::sort(sorted);
+            EXPECT_EQ(sorted, expected);
+
+            /* Sorted, reversed and appended to, the presorted inputs */
+            algorithm::sort(sorted);
+            EXPECT_EQ(sorted, expected);
+            std::reverse(sorted.begin(), sorted.end());
+            algorithm::sort(sorted);
+            EXPECT_EQ(sorted, expected);
+
+            auto descending = values;
+            algorithm::sort(descending, std::greater<>{});
+            EXPECT_TRUE(std::equal(descending.begin(), descending.end(), expected.rbegin(), expected.rend()));
+        }
+    }
+
+    std::vector<std::string> words(5000);
+    std::uniform_int_distribution<int> letter{'a', 'z'};
+    for (auto& word : words)
+    {
+        word = std::string(8, 'a');
+        std::generate(word.begin(), word.end(), [&] { return static_cast<char>(letter(generator)); });
+    }
+    auto expected_words = words;
+    std::sort(expected_words.begin(), expected_words.end());
+    algorithm::sort(words);
+    EXPECT_EQ(words, expected_words);
+
+    auto records = random_keyed_values(5000, 100);
+    algorithm::sort(records, std::greater<>{}, &keyed_value::key);
+    EXPECT_TRUE(std::is_sorted(records.begin(), records.end(), [](const auto& lhs, const auto& rhs) { return lhs.key > rhs.key; }));
+
+    std::list<int> list{5, 3, 9, 1, 7, 3};
+    algorithm::sort(list);
+    EXPECT_THAT(list, testing::ElementsAre(1, 3, 3, 5, 7, 9));
+    std::deque<double> reals{2.5, -1.0, 0.0, -0.5};
+    algorithm::sort(reals, algorithm::sort_thresholds{.network = 0, .insertion = 0, .radix = 0});
+    EXPECT_THAT(reals, testing::ElementsAre(-1.0, -0.5, 0.0, 2.5));
+}
+
+TEST(selection, nth_element_of_random_and_adversarial_ranges)
+{
+    std::mt19937 generator{42};
+    std::vector<std::vector<int>> inputs;
+    for (const int domain : {std::numeric_limits<int>::max(), 1000, 3})
+    {
+        std::uniform_int_distribution<int> distribution{-domain / 2, domain / 2};
+        std::vector<int> values(100000);
+        std::generate(values.begin(), values.end(), [&] { return distribution(generator); });
+        inputs.push_back(values);
+    }
+
+    /* Sorted, reversed and organ pipe inputs defeat naive pivots */
+    std::vector<int> organ_pipe(20000);
+    for (std::size_t index = 0; index < organ_pipe.size(); ++index)
+    {
+        organ_pipe[index] = static_cast<int>(std::min(index, organ_pipe.size() - index));
+    }
+    auto sorted = inputs.front();
+    std::sort(sorted.begin(), sorted.end());
+    inputs.push_back(organ_pipe);
+    inputs.push_back(sorted);
+    inputs.push_back(std::vector<int>(sorted.rbegin(), sorted.rend()));
+
+    for (const auto& values : inputs)
+    {
+        auto expected = values;
+        std::sort(expected.begin(), expected.end());
+        for (const std::size_t nth : {std::size_t{0}, std::size_t{17}, values.size() / 3, values.size() / 2, values.size() - 1})
+        {
+            auto selected = values;
+            algorithm::nth_element(selected, nth);
+            ASSERT_EQ(selected[nth], expected[nth]);
+            EXPECT_TRUE(std::all_of(selected.begin(), selected.begin() + nth, [&](int value) { return value <= selected[nth]; }));
+            EXPECT_TRUE(std::all_of(selected.begin() + nth, selected.end(), [&](int value) { return value >= selected[nth]; }));
+        }
+    }
+
+    /* Past the end there is nothing to select */
+    std::vector<int> short_range{3, 1, 2};
+    algorithm::nth_element(short_range, 3);
+    EXPECT_THAT(short_range, testing::ElementsAre(3, 1, 2));
+
+    auto records = random_keyed_values(5000, 100);
+    algorithm::nth_element(records, 10, std::greater<>{}, &keyed_value::key);
+    EXPECT_TRUE(std::all_of(records.begin() + 10, records.end(), [&](const auto& record) { return record.key <= records[10].key; }));
+
+    std::list<std::string> words{"delta", "alpha", "echo", "charlie", "bravo"};
+    algorithm::nth_element(words, 1);
+    EXPECT_EQ(*std::next(words.begin()), "bravo");
+}
+
+TEST(selection, partial_sort_by_heap_and_by_selection)
+{
+    std::mt19937 generator{42};
+    std::uniform_int_distribution<int> distribution{-1000000, 1000000};
+    std::vector<int> values(200000);
+    std::generate(values.begin(), values.end(), [&] { return distribution(generator); });
+    auto expected = values;
+    std::sort(expected.begin(), expected.end());
+
+    /* Up to one element per 1024 goes through the heap, more are selected and sorted */
+    for (const std::size_t count : {std::size_t{0}, std::size_t{1}, std::size_t{100}, std::size_t{50000}, values.size(), values.size() + 1})
+    {
+        auto partially_sorted = values;
+        algorithm::partial_sort(partially_sorted, count);
+        const auto sorted_size = static_cast<std::ptrdiff_t>(std::min(count, values.size()));
+        EXPECT_TRUE(std::equal(partially_sorted.begin(), partially_sorted.begin() + sorted_size, expected.begin()));
+
+        std::sort(partially_sorted.begin(), partially_sorted.end());
+        EXPECT_EQ(partially_sorted, expected);
+    }
+
+    std::deque<double> reals{2.5, -1.0, 0.0, 7.5, -0.5};
+    algorithm::partial_sort(reals, 2, std::greater<>{});
+    EXPECT_THAT(std::vector<double>(reals.begin(), reals.begin() + 2), testing::ElementsAre(7.5, 2.5));
+    std::list<int> list{5, 3, 9, 1, 7, 3};
+    algorithm::partial_sort(list, 3);
+    EXPECT_THAT(std::vector<int>(list.begin(), std::next(list.begin(), 3)), testing::ElementsAre(1, 3, 3));
+}
+
+TEST(selection, top_k_of_read_only_ranges)
+{
+    std::mt19937 generator{42};
+    std::uniform_real_distribution<float> distribution{0.0f, 1.0f};
+    std::vector<float> scores(300000);
+    std::generate(scores.begin(), scores.end(), [&] { return distribution(generator); });
+    const auto& read_only = scores;
+    auto expected = scores;
+    std::sort(expected.begin(), expected.end());
+
+    for (const std::size_t k : {std::size_t{0}, std::size_t{1}, std::size_t{100}, std::size_t{1000}, scores.size() + 1})
+    {
+        const auto smallest = algorithm::top_k(read_only, k);
+        ASSERT_EQ(smallest.size(), std::min(k, scores.size()));
+        EXPECT_TRUE(std::equal(smallest.begin(), smallest.end(), expected.begin()));
+
+        const auto largest = algorithm::top_k(read_only, k, std::greater<>{});
+        EXPECT_TRUE(std::equal(largest.begin(), largest.end(), expected.rbegin()));
+    }
+
+    /* Other element types are filtered by the comparator, the range is never modified */
+    std::vector<std::int64_t> integers(20000);
+    std::iota(integers.begin(), integers.end(), std::int64_t{-10000});
+    std::shuffle(integers.begin(), integers.end(), generator);
+    EXPECT_THAT(algorithm::top_k(integers, 3), testing::ElementsAre(-10000, -9999, -9998));
+    EXPECT_THAT(algorithm::top_k(integers, 3, std::greater<>{}), testing::ElementsAre(9999, 9998, 9997));
+
+    const auto records = random_keyed_values(5000, 1000);
+    const auto best = algorithm::top_k(records, 5, std::greater<>{}, &keyed_value::key);
+    auto expected_records = records;
+    std::sort(expected_records.begin(), expected_records.end(), [](const auto& lhs, const auto& rhs) { return lhs.key > rhs.key; });
+    ASSERT_EQ(best.size(), 5u);
+    for (std::size_t index = 0; index < best.size(); ++index)
+    {
+        EXPECT_EQ(best[index].key, expected_records[index].key);
+    }
+
+    const std::list<std::string> words{"delta", "alpha", "echo", "charlie", "bravo"};
+    EXPECT_THAT(algorithm::top_k(words, 2), testing::ElementsAre("alpha", "bravo"));
+}
+
+TEST(top_k_stream, keep_smallest_values_of_a_stream)
+{
+    std::mt19937 generator{42};
+    std::uniform_int_distribution<int> distribution{-1000000, 1000000};
+    for (const std::size_t size : {0u, 1u, 99u, 100u, 199u, 200u, 201u, 100000u})
+    {
+        std::vector<int> values(size);
+        std::generate(values.begin(), values.end(), [&] { return distribution(generator); });
+        auto expected = values;
+        std::sort(expected.begin(), expected.end());
+        expected.resize(std::min<std::size_t>(size, 100));
+
+        algorithm::top_k_stream<int, 100> one_by_one;
+        for (const auto value : values)
+        {
+            one_by_one.push(value);
+        }
+
+        /* Batches of odd sizes leave tails the vectorized scan does not cover */
+        algorithm::top_k_stream<int, 100> batches;
+        for (std::size_t offset = 0; offset < size; offset += 37)
+        {
+            batches.push_range(std::span<const int>{values.data() + offset, std::min<std::size_t>(37, size - offset)});
+        }
+
+        /* Two halves filled separately, as two threads would */
+        algorithm::top_k_stream<int, 100> merged;
+        algorithm::top_k_stream<int, 100> other;
+        merged.push_range(std::span<const int>{values.data(), size / 3});
+        other.push_range(std::span<const int>{values.data() + size / 3, size - size / 3});
+        merged.merge(other);
+
+        for (const auto* stream : {&one_by_one, &batches, &merged})
+        {
+            EXPECT_EQ(stream->seen(), size);
+            EXPECT_EQ(stream->size(), expected.size());
+            EXPECT_EQ(stream->sorted(), expected);
+
+            auto top = stream->top();
+            std::sort(top.begin(), top.end());
+            EXPECT_EQ(top, expected);
+        }
+    }
+}
+
+TEST(top_k_stream, keep_values_first_by_comparator)
+{
+    std::mt19937 generator{42};
+    std::uniform_real_distribution<double> distribution{0.0, 1.0};
+    std::vector<double> latencies(50000);
+    std::generate(latencies.begin(), latencies.end(), [&] { return distribution(generator); });
+    auto expected = latencies;
+    std::sort(expected.begin(), expected.end(), std::greater<>{});
+
+    algorithm::top_k_stream<double, 10, std::greater<>> slowest;
+    slowest.push_range(latencies);
+    EXPECT_EQ(slowest.sorted(), std::vector<double>(expected.begin(), expected.begin() + 10));
+
+    slowest.clear();
+    EXPECT_EQ(slowest.seen(), 0u);
+    EXPECT_THAT(slowest.sorted(), testing::IsEmpty());
+    slowest.push(2.0);
+    slowest.push(3.0);
+    EXPECT_THAT(slowest.sorted(), testing::ElementsAre(3.0, 2.0));
+
+    const auto by_length = [](const std::string& lhs, const std::string& rhs) { return lhs.size() > rhs.size(); };
+    algorithm::top_k_stream<std::string, 2, decltype(by_length)> longest{by_length};
+    for (std::string word : {"a", "abcd", "ab", "abcdef", "abc"})
+    {
+        longest.push(std::move(word));
+    }
+    EXPECT_THAT(longest.sorted(), testing::ElementsAre("abcdef", "abcd"));
+}
+
+TEST(top_k_stream, push_batches_of_another_type)
+{
+    /* The threshold 2.5 must not be truncated to 2 when it is compared with integers */
+    algorithm::top_k_stream<double, 2> batched;
+    algorithm::top_k_stream<double, 2> one_by_one;
+    for (const double value : {1.0, 2.5, 3.0, 4.0})
+    {
+        batched.push(value);
+        one_by_one.push(value);
+    }
+    const std::vector<int> integers(64, 2);
+    batched.push_range(integers);
+    for (const int value : integers)
+    {
+        one_by_one.push(value);
+    }
+    EXPECT_THAT(batched.sorted(), testing::ElementsAre(1.0, 2.0));
+    EXPECT_EQ(batched.sorted(), one_by_one.sorted());
+
+    algorithm::top_k_stream<std::int64_t, 3> wide;
+    wide.push_range(std::vector<int>{5, -7, 3, 9, -1, 0});
+    EXPECT_THAT(wide.sorted(), testing::ElementsAre(-7, -1, 0));
+}
+
+TEST(top_k_stream, answer_tail_quantiles)
+{
+    std::vector<double> latencies(100000);
+    std::iota(latencies.begin(), latencies.end(), 0.0);
+    std::shuffle(latencies.begin(), latencies.end(), std::mt19937{42});
+
+    algorithm::top_k_stream<double, 1000, std::greater<>> slowest;
+    EXPECT_EQ(slowest.quantile(0.5), std::nullopt);
+    slowest.push_range(latencies);
+
+    /* Ranks are counted from the largest value here, so quantile(0.001) is the 99.9th percentile */
+    EXPECT_EQ(slowest.quantile(0.0), 99999.0);
+    EXPECT_EQ(slowest.quantile(0.001), 99999.0 - 99.0);
+    EXPECT_EQ(slowest.quantile(0.009), 99999.0 - 899.0);
+    EXPECT_EQ(slowest.quantile(0.5), std::nullopt);
+    EXPECT_EQ(slowest.quantile(1.5), std::nullopt);
+
+    /* Until K values are seen every quantile is kept */
+    algorithm::top_k_stream<int, 100> few;
+    for (const int value : {40, 10, 30, 20, 50})
+    {
+        few.push(value);
+    }
+    EXPECT_EQ(few.quantile(0.5), 30);
+    EXPECT_EQ(few.quantile(1.0), 50);
+}
+
+TEST(scratch_memory, merge_sort_with_any_scratch_size)
+{
+    const auto values = random_keyed_values(5000, 50);
+    auto expected = values;
+    std::stable_sort(expected.begin(), expected.end());
+
+    for (const std::size_t elements : {std::size_t{0}, std::size_t{1}, std::size_t{100}, values.size() / 2, values.size()})
+    {
+        std::vector<keyed_value> scratch(elements);
+        const auto bytes = std::as_writable_bytes(std::span{scratch});
+
+        auto top_down = values;
+        algorithm::merge_sort(top_down, bytes);
+        EXPECT_EQ(top_down, expected);
+
+        auto bottom_up = values;
+        algorithm::bottom_up_merge_sort(bottom_up, bytes);
+        EXPECT_EQ(bottom_up, expected);
+    }
+}
+
+TEST(scratch_memory, merge_sort_with_limited_resource)
+{
+    const auto values = random_keyed_values(5000, 50);
+    auto expected = values;
+    std::stable_sort(expected.begin(), expected.end());
+
+    for (const std::size_t limit : {std::size_t{0}, 64 * sizeof(keyed_value), values.size() * sizeof(keyed_value)})
+    {
+        limited_resource resource{limit};
+
+        auto top_down = values;
+        algorithm::merge_sort(top_down, &resource);
+        EXPECT_EQ(top_down, expected);
+
+        auto bottom_up = values;
+        algorithm::bottom_up_merge_sort(bottom_up, &resource);
+        EXPECT_EQ(bottom_up, expected);
+        EXPECT_EQ(resource.allocated, 0);
+    }
+}
+
+TEST(scratch_memory, buffered_sorts_with_any_scratch_size)
+{
+    std::mt19937 generator{42};
+    std::uniform_int_distribution<int> distribution{-1000, 1000};
+
+    Range values(5000);
+    std::generate(values.begin(), values.end(), [&] { return distribution(generator); });
+    auto expected = values;
+    std::sort(expected.begin(), expected.end());
+
+    for (const std::size_t bytes : {std::size_t{0}, std::size_t{64}, std::size_t{1} << 20})
+    {
+        std::vector<std::byte> scratch(bytes);
+
+        auto radix = values;
+        algorithm::radix_sort(radix, std::span{scratch});
+        EXPECT_EQ(radix, expected);
+
+        auto bucket = values;
+        algorithm::bucket_sort(bucket, std::span{scratch});
+        EXPECT_EQ(bucket, expected);
+
+        auto counting = values;
+        algorithm::counting_sort(counting, std::span{scratch});
+        EXPECT_EQ(counting, expected);
+
+        limited_resource resource{bytes};
+        auto counting_with_resource = values;
+        algorithm::counting_sort(counting_with_resource, &resource);
+        EXPECT_EQ(counting_with_resource, expected);
+        EXPECT_EQ(resource.allocated, 0);
+    }
+}
+
+TEST(power_sort, sort_large_range_stably)
+{
+    for (const int keys : {2, 100, 100000})
+    {
+        auto values = random_keyed_values(10007, keys);
+        auto expected = values;
+        std::stable_sort(expected.begin(), expected.end());
+
+        algorithm::power_sort(values);
+        EXPECT_EQ(values, expected);
+    }
+}
+
+TEST(power_sort, sort_concatenated_runs_stably)
+{
+    /* Ascending, strictly descending and constant runs of different lengths, with keys repeating across runs */
+    std::vector<keyed_value> values;
+    int order = 0;
+    for (int run = 0; run < 50; ++run)
+    {
+        const int length = 1 + (run * 37) % 500;
+        for (int index = 0; index < length; ++index)
+        {
+            const int key = run % 3 == 0 ? index : (run % 3 == 1 ? length - index : 7);
+            values.push_back({key, order++});
+        }
+    }
+    auto expected = values;
+    std::stable_sort(expected.begin(), expected.end());
+
+    auto list = std::list<keyed_value>{values.begin(), values.end()};
+    algorithm::power_sort(values);
+    EXPECT_EQ(values, expected);
+
+    algorithm::power_sort(list);
+    EXPECT_TRUE(std::equal(list.begin(), list.end(), expected.begin(), expected.end()));
+}
+
+/* Counts comparisons, to check how much work sorts do on presorted input */
+struct counted_value
+{
+    int value;
+    static inline std::size_t comparisons = 0;
+
+    bool operator<(const counted_value& other) const
+    {
+        ++comparisons;
+        return value < other.value;
+    }
+    bool operator>(const counted_value& other) const
+    {
+        return other < *this;
+    }
+};
+
+TEST(power_sort, sort_presorted_range_in_linear_time)
+{
+    constexpr int size = 100000;
+    std::vector<counted_value> values(size);
+    for (int index = 0; index < size; ++index)
+    {
+        /* Two runs: the first half ascending, then the second half descending through values larger than all of the first */
+        values[static_cast<std::size_t>(index)].value = index < size / 2 ? index : 3 * size / 2 - index;
+    }
+
+    counted_value::comparisons = 0;
+    algorithm::power_sort(values);
+    EXPECT_TRUE(std::is_sorted(values.begin(), values.end(), [](auto lhs, auto rhs) { return lhs.value < rhs.value; }));
+    EXPECT_LT(counted_value::comparisons, 2 * static_cast<std::size_t>(size));
+}